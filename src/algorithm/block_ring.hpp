@@ -0,0 +1,143 @@
+#ifndef CCWC_ALGORITHM_BLOCK_RING_HPP
+#define CCWC_ALGORITHM_BLOCK_RING_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Fixed ring of byte blocks handed from one producer thread to one consumer thread.
+     *
+     * The producer acquires an empty block, fills it and publishes it; the consumer takes
+     * published blocks in order and releases them back once it is done with them. The blocks are
+     * allocated once up front, so no memory is allocated while streaming.
+     */
+    class BlockRing
+    {
+      public:
+        /**
+         * @brief A block of bytes and the number of valid bytes in it.
+         */
+        struct Block
+        {
+            std::vector<unsigned char> mData;
+            std::size_t                mSize{0};
+        };
+
+      private:
+        std::vector<Block>      m_blocks;
+        std::size_t             m_head{0};      // Next block the consumer takes.
+        std::size_t             m_tail{0};      // Next block the producer fills.
+        std::size_t             m_published{0}; // Number of published, not yet taken blocks.
+        std::size_t             m_inUse{0};     // Blocks taken by the consumer, not released.
+        bool                    m_closed{false};
+        std::mutex              m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param blockCount Number of blocks in the ring.
+         * @param blockSize Capacity of each block in bytes.
+         */
+        BlockRing(std::size_t blockCount, std::size_t blockSize) : m_blocks(blockCount)
+        {
+            for (auto& block : m_blocks)
+            {
+                block.mData.resize(blockSize);
+            }
+        }
+
+        ~BlockRing() = default;
+
+        BlockRing(const BlockRing&)                    = delete;
+        auto operator=(const BlockRing&) -> BlockRing& = delete;
+        BlockRing(BlockRing&&)                         = delete;
+        auto operator=(BlockRing&&) -> BlockRing&      = delete;
+
+        /**
+         * @brief Producer side: wait for an empty block.
+         * @return The block to fill, or nullptr once the ring was closed.
+         */
+        auto acquire() -> Block*
+        {
+            std::unique_lock lock(m_mutex);
+            m_notFull.wait(lock, [this]
+                           { return m_closed || m_published + m_inUse < m_blocks.size(); });
+            if (m_closed)
+            {
+                return nullptr;
+            }
+            return &m_blocks[m_tail];
+        }
+
+        /**
+         * @brief Producer side: publish the block returned by the last acquire().
+         */
+        auto publish() -> void
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_tail = (m_tail + 1) % m_blocks.size();
+                ++m_published;
+            }
+            m_notEmpty.notify_one();
+        }
+
+        /**
+         * @brief Consumer side: wait for the next published block.
+         * @return The block, or nullptr once the ring is closed and drained.
+         */
+        auto take() -> const Block*
+        {
+            std::unique_lock lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return m_closed || m_published > 0; });
+            if (m_published == 0)
+            {
+                return nullptr;
+            }
+            const Block* block = &m_blocks[m_head];
+            m_head             = (m_head + 1) % m_blocks.size();
+            --m_published;
+            ++m_inUse;
+            return block;
+        }
+
+        /**
+         * @brief Consumer side: hand the block returned by the last take() back to the producer.
+         */
+        auto release() -> void
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                --m_inUse;
+            }
+            m_notFull.notify_one();
+        }
+
+        /**
+         * @brief Close the ring, waking both sides.
+         *
+         * Called by the producer once it is done (the consumer still drains published blocks) or
+         * by the consumer to abandon the stream (the producer stops acquiring).
+         */
+        auto close() -> void
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_closed = true;
+            }
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_BLOCK_RING_HPP
@@ -0,0 +1,466 @@
+#include "compressed_input_stream.hpp"
+
+#include "block_ring.hpp"
+#include "exception/exception.hpp"
+#include "trace.hpp"
+#include "universal_input_stream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/lzma.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <mutex>
+#include <poll.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr std::array<unsigned char, 2> GZIP_MAGIC{0x1F, 0x8B};
+        constexpr std::array<unsigned char, 4> ZSTD_MAGIC{0x28, 0xB5, 0x2F, 0xFD};
+        constexpr std::array<unsigned char, 6> XZ_MAGIC{0xFD, '7', 'z', 'X', 'Z', 0x00};
+        constexpr std::array<unsigned char, 3> BZIP2_MAGIC{'B', 'Z', 'h'};
+
+        /**
+         * @brief Number of blocks in the ring between the decoder and the counting thread.
+         */
+        constexpr std::size_t DECODE_RING_BLOCKS = 4;
+
+        /**
+         * @brief Size of each decoded block.
+         */
+        constexpr std::size_t DECODE_BLOCK_SIZE = static_cast<std::size_t>(256 * 1024); // 256KiB
+
+        template <std::size_t N>
+        auto startsWith(std::span<const unsigned char>        header,
+                        const std::array<unsigned char, N>& magic) -> bool
+        {
+            return header.size() >= N && std::equal(magic.begin(), magic.end(), header.begin());
+        }
+
+        /**
+         * @brief The name of a format, as reported by `--stats`.
+         */
+        auto formatName(CompressionFormat format) -> std::string_view
+        {
+            switch (format)
+            {
+            case CompressionFormat::GZIP:
+                return "gzip";
+            case CompressionFormat::ZSTD:
+                return "zstd";
+            case CompressionFormat::XZ:
+                return "xz";
+            case CompressionFormat::BZIP2:
+                return "bzip2";
+            case CompressionFormat::NONE:
+            case CompressionFormat::AUTO:
+                break;
+            }
+            return "read";
+        }
+
+        /**
+         * @brief Read as many bytes as possible, retrying on EINTR and short reads.
+         * @param reads Incremented for every read() call.
+         * @param wakeFd If valid, each read first waits for `fd` with poll() and gives up with
+         * ECANCELED as soon as `wakeFd` becomes readable instead.
+         * @return Number of bytes read, or -1 on error.
+         */
+        auto readFully(int fd, char* buffer, std::size_t size, std::atomic<std::uint64_t>& reads,
+                       int wakeFd = -1) -> std::streamsize
+        {
+            TraceSpan   span("read");
+            std::size_t total{0};
+            while (total < size)
+            {
+                if (wakeFd >= 0)
+                {
+                    std::array<pollfd, 2> waiting{{{fd, POLLIN, 0}, {wakeFd, POLLIN, 0}}};
+                    if (::poll(waiting.data(), waiting.size(), -1) < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+                        return -1;
+                    }
+                    if (waiting[1].revents != 0)
+                    {
+                        errno = ECANCELED;
+                        return -1;
+                    }
+                }
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                ssize_t bytesRead = ::read(fd, buffer + total, size - total);
+                reads.fetch_add(1, std::memory_order_relaxed);
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (bytesRead < 0)
+                {
+                    return -1;
+                }
+                if (bytesRead == 0)
+                {
+                    break;
+                }
+                total += static_cast<std::size_t>(bytesRead);
+            }
+            span.setBytes(total);
+            return static_cast<std::streamsize>(total);
+        }
+
+        /**
+         * @brief Boost.Iostreams source reading from a descriptor, replaying the bytes that were
+         * already consumed to detect the format first.
+         */
+        class PeekedDescriptorSource
+        {
+          public:
+            using char_type = char;
+            using category  = boost::iostreams::source_tag;
+
+          private:
+            int                                      m_fd;
+            std::array<char, COMPRESSION_MAGIC_SIZE> m_peeked{};
+            std::size_t                              m_peekedSize{0};
+            std::size_t                              m_peekedPos{0};
+            std::atomic<std::uint64_t>*              m_reads;
+            int                                      m_wakeFd;
+
+          public:
+            PeekedDescriptorSource(int fd, std::span<const unsigned char> peeked,
+                                   std::atomic<std::uint64_t>& reads, int wakeFd)
+                : m_fd(fd), m_reads(&reads), m_wakeFd(wakeFd)
+            {
+                m_peekedSize = std::min(peeked.size(), m_peeked.size());
+                std::copy_n(peeked.begin(), m_peekedSize, m_peeked.begin());
+            }
+
+            auto read(char* buffer, std::streamsize size) -> std::streamsize
+            {
+                auto        wanted = static_cast<std::size_t>(size);
+                std::size_t copied = std::min(wanted, m_peekedSize - m_peekedPos);
+                std::copy_n(m_peeked.begin() + static_cast<std::ptrdiff_t>(m_peekedPos), copied,
+                            buffer);
+                m_peekedPos += copied;
+
+                if (copied == wanted)
+                {
+                    return size;
+                }
+
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                std::streamsize bytesRead =
+                    readFully(m_fd, buffer + copied, wanted - copied, *m_reads, m_wakeFd);
+                if (bytesRead < 0)
+                {
+                    throw std::ios_base::failure(std::strerror(errno));
+                }
+                auto total = static_cast<std::streamsize>(copied) + bytesRead;
+                return total == 0 ? -1 : total;
+            }
+        };
+
+        /**
+         * @brief Input stream that decodes compressed data on a dedicated thread.
+         *
+         * The decoder thread is started on the first read, so opening many compressed inputs
+         * up front does not spawn a thread per input. Decoded data is handed to the counting
+         * thread through a BlockRing; a decoding error is reported to the counting thread as a
+         * FileOperationException once every block decoded before the error was consumed.
+         *
+         * A pipe or terminal can block the decoder in read() for as long as its writer likes, so
+         * for anything but a regular file the decoder polls a wake pipe along with its input;
+         * the destructor writes to it, so an input abandoned early does not hang the join.
+         */
+        class DecompressingInputStream : public UniversalInputStream
+        {
+          private:
+            std::string                    m_name;
+            FileDescriptor                 m_fd;
+            bool                           m_isStdin;
+            CompressionFormat              m_format;
+            BlockRing                      m_ring{DECODE_RING_BLOCKS, DECODE_BLOCK_SIZE};
+            const BlockRing::Block*        m_current{nullptr};
+            std::size_t                    m_pos{0};
+            bool                           m_started{false};
+            bool                           m_finished{false};
+            std::mutex                     m_errorMutex;
+            std::string                    m_error;
+            std::atomic<std::uint64_t>     m_reads{0};
+            std::atomic<CompressionFormat> m_detected{CompressionFormat::NONE};
+            FileDescriptor                 m_wakeRead;  // Only for inputs that can block.
+            FileDescriptor                 m_wakeWrite;
+            std::jthread                   m_decoder;
+
+            /**
+             * @brief Body of the decoder thread.
+             */
+            auto decode() -> void
+            {
+                nameTracedThread("decoder");
+                try
+                {
+                    std::array<unsigned char, COMPRESSION_MAGIC_SIZE> header{};
+                    std::streamsize                                   headerSize =
+                        readFully(m_fd.get(), reinterpret_cast<char*>(header.data()), // NOLINT
+                                  header.size(), m_reads, m_wakeRead.get());
+                    if (headerSize < 0)
+                    {
+                        throw std::ios_base::failure(std::strerror(errno));
+                    }
+                    std::span<const unsigned char> peeked{header.data(),
+                                                          static_cast<std::size_t>(headerSize)};
+
+                    CompressionFormat format = m_format;
+                    if (format == CompressionFormat::AUTO)
+                    {
+                        format = detectCompressionFormat(peeked);
+                    }
+                    m_detected.store(format, std::memory_order_relaxed);
+
+                    boost::iostreams::filtering_istreambuf input;
+                    switch (format)
+                    {
+                    case CompressionFormat::GZIP:
+                        input.push(boost::iostreams::gzip_decompressor());
+                        break;
+                    case CompressionFormat::ZSTD:
+                        input.push(boost::iostreams::zstd_decompressor());
+                        break;
+                    case CompressionFormat::XZ:
+                        input.push(boost::iostreams::lzma_decompressor());
+                        break;
+                    case CompressionFormat::BZIP2:
+                        input.push(boost::iostreams::bzip2_decompressor());
+                        break;
+                    case CompressionFormat::NONE:
+                    case CompressionFormat::AUTO:
+                        break;
+                    }
+                    input.push(
+                        PeekedDescriptorSource(m_fd.get(), peeked, m_reads, m_wakeRead.get()));
+
+                    while (auto* block = m_ring.acquire())
+                    {
+                        TraceSpan span("decode", m_name);
+                        auto      decoded =
+                            input.sgetn(reinterpret_cast<char*>(block->mData.data()), // NOLINT
+                                        static_cast<std::streamsize>(block->mData.size()));
+                        if (decoded <= 0)
+                        {
+                            break;
+                        }
+                        block->mSize = static_cast<std::size_t>(decoded);
+                        span.setBytes(block->mSize);
+                        m_ring.publish();
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    std::lock_guard lock(m_errorMutex);
+                    m_error = e.what();
+                }
+                m_ring.close();
+            }
+
+            /**
+             * @brief Move on to the next decoded block.
+             * @return True if a block with data is available.
+             */
+            auto nextBlock() -> bool
+            {
+                if (m_finished)
+                {
+                    return false;
+                }
+                if (!m_started)
+                {
+                    m_started = true;
+                    struct stat info{};
+                    std::array<int, 2> wake{-1, -1};
+                    if ((::fstat(m_fd.get(), &info) != 0 || !S_ISREG(info.st_mode)) &&
+                        ::pipe(wake.data()) == 0)
+                    {
+                        m_wakeRead  = FileDescriptor{wake[0]};
+                        m_wakeWrite = FileDescriptor{wake[1]};
+                    }
+                    m_decoder = std::jthread([this] { decode(); });
+                }
+                if (m_current != nullptr)
+                {
+                    m_ring.release();
+                }
+                m_current = m_ring.take();
+                m_pos     = 0;
+                if (m_current != nullptr)
+                {
+                    return true;
+                }
+
+                m_finished = true;
+                m_decoder.join();
+                if (!m_error.empty())
+                {
+                    throw ccwc::exception::FileOperationException(m_name + ": " + m_error);
+                }
+                return false;
+            }
+
+          public:
+            DecompressingInputStream(std::string name, FileDescriptor fd, bool isStdin,
+                                     CompressionFormat format)
+                : m_name(std::move(name)), m_fd(std::move(fd)), m_isStdin(isStdin),
+                  m_format(format)
+            {
+            }
+
+            /**
+             * @brief Destructor: stops the decoder before the ring and descriptor go away.
+             */
+            ~DecompressingInputStream() override
+            {
+                m_ring.close();
+                if (m_wakeWrite.valid())
+                {
+                    const char wake{0};
+                    (void)::write(m_wakeWrite.get(), &wake, 1);
+                }
+                if (m_decoder.joinable())
+                {
+                    m_decoder.join();
+                }
+            }
+
+            DecompressingInputStream(const DecompressingInputStream&) = delete;
+            auto operator=(const DecompressingInputStream&)
+                -> DecompressingInputStream&                     = delete;
+            DecompressingInputStream(DecompressingInputStream&&) = delete;
+            auto operator=(DecompressingInputStream&&) -> DecompressingInputStream& = delete;
+
+            [[nodiscard]] auto name() const -> std::string override
+            {
+                return m_name;
+            }
+
+            [[nodiscard]] auto isStdin() const -> bool override
+            {
+                return m_isStdin;
+            }
+
+            auto nextByte() -> std::optional<unsigned char> override
+            {
+                while (m_current == nullptr || m_pos >= m_current->mSize)
+                {
+                    if (!nextBlock())
+                    {
+                        return std::nullopt;
+                    }
+                }
+                return m_current->mData[m_pos++];
+            }
+
+            auto reset() -> bool override
+            {
+                return false; // decoding is a one-way pipeline
+            }
+
+            [[nodiscard]] auto good() const -> bool override
+            {
+                return !m_finished;
+            }
+
+            /**
+             * @brief The detected format, "read" if the data was passed through undecoded.
+             */
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return formatName(m_detected.load(std::memory_order_relaxed));
+            }
+
+            [[nodiscard]] auto countsOffThread() const -> bool override
+            {
+                return true;
+            }
+
+            /**
+             * @brief The read() calls of the decoder thread.
+             */
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return m_reads.load(std::memory_order_relaxed);
+            }
+        };
+    } // namespace detail
+
+    auto detectCompressionFormat(std::span<const unsigned char> header) -> CompressionFormat
+    {
+        if (detail::startsWith(header, detail::GZIP_MAGIC))
+        {
+            return CompressionFormat::GZIP;
+        }
+        if (detail::startsWith(header, detail::ZSTD_MAGIC))
+        {
+            return CompressionFormat::ZSTD;
+        }
+        if (detail::startsWith(header, detail::XZ_MAGIC))
+        {
+            return CompressionFormat::XZ;
+        }
+        if (detail::startsWith(header, detail::BZIP2_MAGIC))
+        {
+            return CompressionFormat::BZIP2;
+        }
+        return CompressionFormat::NONE;
+    }
+
+    auto parseCompressionFormat(std::string_view name) -> std::optional<CompressionFormat>
+    {
+        if (name == "auto")
+        {
+            return CompressionFormat::AUTO;
+        }
+        if (name == "gzip" || name == "gz")
+        {
+            return CompressionFormat::GZIP;
+        }
+        if (name == "zstd" || name == "zst")
+        {
+            return CompressionFormat::ZSTD;
+        }
+        if (name == "xz" || name == "lzma")
+        {
+            return CompressionFormat::XZ;
+        }
+        if (name == "bzip2" || name == "bz2")
+        {
+            return CompressionFormat::BZIP2;
+        }
+        return std::nullopt;
+    }
+
+    auto createDecompressingInputStream(std::string name, FileDescriptor fd, bool isStdin,
+                                        CompressionFormat format)
+        -> std::unique_ptr<UniversalInputStream>
+    {
+        return std::make_unique<detail::DecompressingInputStream>(std::move(name), std::move(fd),
+                                                                  isStdin, format);
+    }
+
+} // namespace ccwc::algorithm
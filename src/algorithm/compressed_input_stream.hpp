@@ -0,0 +1,68 @@
+#ifndef CCWC_ALGORITHM_COMPRESSED_INPUT_STREAM_HPP
+#define CCWC_ALGORITHM_COMPRESSED_INPUT_STREAM_HPP
+
+#include "file_descriptor.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace ccwc::algorithm
+{
+
+    class UniversalInputStream;
+
+    /**
+     * @brief Compression formats understood by the decompressing input streams.
+     */
+    enum class CompressionFormat : std::uint8_t
+    {
+        NONE,  // Do not decompress.
+        AUTO,  // Select the decompressor from the magic bytes at the start of the input.
+        GZIP,  // RFC 1952, including multi-member files.
+        ZSTD,  // Zstandard frames.
+        XZ,    // xz / lzma2 container.
+        BZIP2, // bzip2 streams.
+    };
+
+    /**
+     * @brief Number of leading bytes needed to recognise every supported format.
+     */
+    constexpr std::size_t COMPRESSION_MAGIC_SIZE = 6;
+
+    /**
+     * @brief Detect the compression format from the first bytes of an input.
+     * @param header Up to COMPRESSION_MAGIC_SIZE leading bytes of the input.
+     * @return The detected format, or CompressionFormat::NONE if no magic matches.
+     */
+    auto detectCompressionFormat(std::span<const unsigned char> header) -> CompressionFormat;
+
+    /**
+     * @brief Parse a format name as accepted by `--decompress=FORMAT`.
+     * @return The format, or std::nullopt if the name is unknown.
+     */
+    auto parseCompressionFormat(std::string_view name) -> std::optional<CompressionFormat>;
+
+    /**
+     * @brief Creates a stream that decompresses the data read from a descriptor.
+     *
+     * Decompression runs on a dedicated thread that fills a ring of blocks which are consumed
+     * by the counting thread, so inflating and counting overlap.
+     *
+     * @param name Logical name of the input.
+     * @param fd Descriptor to read the compressed data from.
+     * @param isStdin Whether the descriptor is the standard input.
+     * @param format The format to decode; AUTO detects it from the magic bytes and passes the
+     * data through unchanged if none matches.
+     * @return A new decompressing input stream.
+     */
+    auto createDecompressingInputStream(std::string name, FileDescriptor fd, bool isStdin,
+                                        CompressionFormat format)
+        -> std::unique_ptr<UniversalInputStream>;
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_COMPRESSED_INPUT_STREAM_HPP
@@ -34,6 +34,19 @@ namespace ccwc::algorithm
 
             return *this;
         }
+
+        /**
+         * @brief Operator to subtract an earlier snapshot of the same count.
+         */
+        auto operator-=(const Counter& other) -> Counter&
+        {
+            this->bytes -= other.bytes;
+            this->words -= other.words;
+            this->lines -= other.lines;
+            this->multibyte -= other.multibyte;
+
+            return *this;
+        }
     };
 
 } // namespace ccwc::algorithm
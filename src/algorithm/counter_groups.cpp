@@ -0,0 +1,80 @@
+#include "counter_groups.hpp"
+
+#include <fnmatch.h>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr std::string_view NO_EXTENSION_GROUP = "(none)";
+        constexpr std::string_view UNMATCHED_GROUP    = "other";
+
+        /**
+         * @brief The last path component (tar members use ':' after the archive name).
+         */
+        auto baseName(std::string_view path) -> std::string_view
+        {
+            std::size_t separator = path.find_last_of("/:");
+            return separator == std::string_view::npos ? path : path.substr(separator + 1);
+        }
+
+        /**
+         * @brief The extension of a file name including the dot, e.g. ".cpp".
+         */
+        auto extensionOf(std::string_view path) -> std::string_view
+        {
+            std::string_view name = baseName(path);
+            std::size_t      dot  = name.rfind('.');
+            // Dot files such as ".bashrc" have no extension.
+            if (dot == std::string_view::npos || dot == 0 || dot + 1 == name.size())
+            {
+                return NO_EXTENSION_GROUP;
+            }
+            return name.substr(dot);
+        }
+
+        auto matches(const std::string& pattern, const std::string& path) -> bool
+        {
+            // The file name is a suffix of the path, so it is NUL-terminated as well.
+            const char* subject =
+                pattern.find('/') == std::string::npos ? baseName(path).data() : path.c_str();
+            return ::fnmatch(pattern.c_str(), subject, 0) == 0;
+        }
+    } // namespace detail
+
+    CounterGroups::CounterGroups(GroupingOptions options) : m_options(std::move(options))
+    {
+    }
+
+    auto CounterGroups::groupOf(const std::string& path) const -> std::string_view
+    {
+        for (const auto& [pattern, group] : m_options.mPatterns)
+        {
+            if (detail::matches(pattern, path))
+            {
+                return group;
+            }
+        }
+        return m_options.mByExtension ? detail::extensionOf(path) : detail::UNMATCHED_GROUP;
+    }
+
+    auto CounterGroups::add(const std::string& path, const Counter& counter) -> void
+    {
+        std::string_view group = groupOf(path);
+
+        // Lookups by string_view only allocate the first time a group is seen.
+        auto total = m_totals.find(group);
+        if (total == m_totals.end())
+        {
+            total = m_totals.emplace(std::string(group), GroupTotal{}).first;
+        }
+        total->second.mCounter += counter;
+        ++total->second.mFiles;
+    }
+
+    auto CounterGroups::totals() const -> const std::map<std::string, GroupTotal, std::less<>>&
+    {
+        return m_totals;
+    }
+
+} // namespace ccwc::algorithm
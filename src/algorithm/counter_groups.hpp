@@ -0,0 +1,90 @@
+#ifndef CCWC_ALGORITHM_COUNTER_GROUPS_HPP
+#define CCWC_ALGORITHM_COUNTER_GROUPS_HPP
+
+#include "counter.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief How counted files are put into groups.
+     */
+    struct GroupingOptions
+    {
+        /**
+         * @brief Glob patterns and the group of the files they match; the first match wins.
+         *
+         * Patterns containing a '/' are matched against the whole path, the others against the
+         * file name only.
+         */
+        std::vector<std::pair<std::string, std::string>> mPatterns;
+
+        /**
+         * @brief Group files matched by no pattern by their extension (otherwise "other").
+         */
+        bool mByExtension{false};
+    };
+
+    /**
+     * @brief The accumulated counts of one group.
+     */
+    struct GroupTotal
+    {
+        /**
+         * @brief Sum of the counters of the files in the group.
+         */
+        Counter mCounter;
+
+        /**
+         * @brief Number of files in the group.
+         */
+        std::size_t mFiles{0};
+    };
+
+    /**
+     * @brief Per-group totals, accumulated while the files are counted.
+     *
+     * Only one Counter per group is kept, so grouping millions of files needs as much memory as
+     * there are groups instead of one row per file.
+     */
+    class CounterGroups
+    {
+      private:
+        GroupingOptions                                m_options;
+        std::map<std::string, GroupTotal, std::less<>> m_totals;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param options How files are put into groups.
+         */
+        explicit CounterGroups(GroupingOptions options);
+
+        /**
+         * @brief The group a file belongs to.
+         * @param path Path of the file, as it would be printed.
+         */
+        [[nodiscard]] auto groupOf(const std::string& path) const -> std::string_view;
+
+        /**
+         * @brief Add the counter of a file to its group.
+         */
+        auto add(const std::string& path, const Counter& counter) -> void;
+
+        /**
+         * @brief The totals of every group, ordered by group name.
+         */
+        [[nodiscard]] auto totals() const -> const std::map<std::string, GroupTotal, std::less<>>&;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_COUNTER_GROUPS_HPP
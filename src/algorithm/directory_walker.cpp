@@ -0,0 +1,464 @@
+#include "directory_walker.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <iterator>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        /**
+         * @brief Upper bound for the number of walker threads picked by default.
+         */
+        constexpr std::size_t MAX_WALKER_THREADS = 8;
+
+        /**
+         * @brief Number of queued subdirectories kept open for openat(); deeper backlogs are
+         * reopened by path so that wide trees cannot exhaust the descriptor limit.
+         */
+        constexpr std::size_t MAX_HELD_DESCRIPTORS = 64;
+
+        /**
+         * @brief Number of files reported to the consumer at once.
+         */
+        constexpr std::size_t FOUND_BATCH_SIZE = 64;
+
+        /**
+         * @brief Number of files found but not taken yet at which the walkers wait for the
+         * consumer; a walk that outpaces the counting would otherwise keep every path of the
+         * tree.
+         */
+        constexpr std::size_t MAX_FOUND = 4096;
+
+        /**
+         * @brief Size of the buffer directory entries are read into.
+         */
+        constexpr std::size_t DIRENT_BUFFER_SIZE = static_cast<std::size_t>(32 * 1024); // 32KiB
+
+        /**
+         * @brief Kind of a directory entry, as far as the walk is concerned.
+         */
+        enum class EntryKind : std::uint8_t
+        {
+            DIRECTORY,
+            REGULAR,
+            OTHER,
+            FAILED // could not be looked at; errno tells why
+        };
+
+        auto kindFromMode(mode_t mode) -> EntryKind
+        {
+            if (S_ISDIR(mode))
+            {
+                return EntryKind::DIRECTORY;
+            }
+            return S_ISREG(mode) ? EntryKind::REGULAR : EntryKind::OTHER;
+        }
+
+        /**
+         * @brief Resolve the kind of an entry, calling fstatat() only when d_type is not enough.
+         */
+        auto entryKind(int dirFd, const char* name, unsigned char type, bool followSymlinks)
+            -> EntryKind
+        {
+            if (type == DT_DIR)
+            {
+                return EntryKind::DIRECTORY;
+            }
+            if (type == DT_REG)
+            {
+                return EntryKind::REGULAR;
+            }
+            if (type != DT_UNKNOWN && !(type == DT_LNK && followSymlinks))
+            {
+                return EntryKind::OTHER;
+            }
+
+            struct stat info{};
+            if (::fstatat(dirFd, name, &info, followSymlinks ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+            {
+                return EntryKind::FAILED; // dangling link, vanished or unreadable entry
+            }
+            return kindFromMode(info.st_mode);
+        }
+
+        /**
+         * @brief Call `visit(name, d_type)` for each entry of an open directory.
+         * @return 0, or the errno if the directory could not be read.
+         */
+        template <typename Visitor> auto forEachEntry(int dirFd, Visitor&& visit) -> int
+        {
+#if defined(__linux__)
+            // The kernel's struct linux_dirent64; glibc only exposes it since 2.30.
+            struct LinuxDirent64
+            {
+                std::uint64_t  mInode;
+                std::int64_t   mOffset;
+                unsigned short mRecordLength;
+                unsigned char  mType;
+                char           mName[1]; // NOLINT(*-avoid-c-arrays)
+            };
+
+            alignas(LinuxDirent64) static thread_local std::array<char, DIRENT_BUFFER_SIZE>
+                buffer;
+
+            while (true)
+            {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+                long bytesRead = ::syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+                if (bytesRead < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return errno;
+                }
+                if (bytesRead == 0)
+                {
+                    return 0;
+                }
+
+                for (std::size_t pos = 0; pos < static_cast<std::size_t>(bytesRead);)
+                {
+                    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                    const auto* entry = reinterpret_cast<const LinuxDirent64*>(&buffer.at(pos));
+                    visit(static_cast<const char*>(entry->mName), entry->mType);
+                    pos += entry->mRecordLength;
+                }
+            }
+#else
+            DIR* dir = ::fdopendir(::dup(dirFd));
+            if (dir == nullptr)
+            {
+                return errno;
+            }
+            errno = 0;
+            while (const dirent* entry = ::readdir(dir))
+            {
+                visit(static_cast<const char*>(entry->d_name), entry->d_type);
+                errno = 0;
+            }
+            int error = errno;
+            ::closedir(dir);
+            return error;
+#endif
+        }
+
+        auto joinPath(const std::string& parent, const char* name) -> std::string
+        {
+            return parent.ends_with('/') ? parent + name : parent + "/" + name;
+        }
+
+        auto openDirectory(const std::string& path) -> FileDescriptor
+        {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+            return FileDescriptor{::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+        }
+    } // namespace detail
+
+    DirectoryWalker::DirectoryWalker(RootSource roots, WalkOptions options,
+                                     std::size_t threadCount)
+        : m_roots(std::move(roots)), m_options(std::move(options))
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1,
+                                                  detail::MAX_WALKER_THREADS);
+        }
+        for (std::size_t i = 0; i < threadCount; ++i)
+        {
+            m_workers.emplace_back([this] { run(); });
+        }
+    }
+
+    DirectoryWalker::~DirectoryWalker()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopped = true;
+        }
+        m_directoriesChanged.notify_all();
+        m_foundChanged.notify_all();
+        m_foundTaken.notify_all();
+    }
+
+    auto DirectoryWalker::waitForRoom(std::unique_lock<std::mutex>& lock) -> void
+    {
+        m_foundTaken.wait(lock,
+                          [this] { return m_stopped || m_found.size() < detail::MAX_FOUND; });
+    }
+
+    auto DirectoryWalker::takeRoot(std::unique_lock<std::mutex>& lock) -> void
+    {
+        m_takingRoot = true;
+        ++m_busy;
+        lock.unlock();
+
+        std::optional<WalkRoot> root;
+        std::exception_ptr      error;
+        bool                    isDirectory{false};
+        try
+        {
+            root = m_roots();
+        }
+        catch (...)
+        {
+            // Rethrown on the consumer's thread once the entries found before are taken.
+            error = std::current_exception();
+        }
+        if (root.has_value() && root->mWalk)
+        {
+            // Roots are followed even if they are links, like the operands of any command.
+            struct stat info{};
+            isDirectory = ::stat(root->mPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+        }
+
+        lock.lock();
+        m_takingRoot = false;
+        if (!root.has_value())
+        {
+            m_rootsDone = true;
+            m_error     = error;
+        }
+        else if (isDirectory)
+        {
+            std::size_t length = root->mPath.size();
+            m_directories.push_back({std::move(root->mPath), root->mIndex, length, {}});
+        }
+        else
+        {
+            // Files, roots that do not exist and roots not to walk are left to the consumer.
+            waitForRoom(lock);
+            std::size_t length = root->mPath.size();
+            m_found.push_back({std::move(root->mPath), root->mIndex, length, 0});
+        }
+        --m_busy;
+        m_directoriesChanged.notify_all();
+        m_foundChanged.notify_all();
+    }
+
+    auto DirectoryWalker::run() -> void
+    {
+        nameTracedThread("walker");
+        while (true)
+        {
+            PendingDirectory directory;
+            {
+                std::unique_lock lock(m_mutex);
+                m_directoriesChanged.wait(lock, [this] {
+                    return m_stopped || !m_directories.empty() || (!m_rootsDone && !m_takingRoot) ||
+                           finished();
+                });
+                if (m_stopped || finished())
+                {
+                    return;
+                }
+                if (m_directories.empty())
+                {
+                    takeRoot(lock);
+                    continue;
+                }
+                directory = std::move(m_directories.front());
+                m_directories.pop_front();
+                if (directory.mFd.valid())
+                {
+                    --m_heldDescriptors;
+                }
+                ++m_busy;
+            }
+
+            walk(directory);
+
+            bool done{false};
+            {
+                std::lock_guard lock(m_mutex);
+                --m_busy;
+                done = finished();
+            }
+            if (done)
+            {
+                m_directoriesChanged.notify_all();
+                m_foundChanged.notify_all();
+            }
+        }
+    }
+
+    auto DirectoryWalker::walk(PendingDirectory& directory) -> void
+    {
+        TraceSpan span("list", directory.mPath);
+        if (!directory.mFd.valid())
+        {
+            directory.mFd = detail::openDirectory(directory.mPath);
+            if (!directory.mFd.valid())
+            {
+                int              error = errno;
+                std::unique_lock lock(m_mutex);
+                waitForRoom(lock);
+                m_found.push_back(
+                    {directory.mPath, directory.mRoot, directory.mRootLength, error});
+                m_foundChanged.notify_one();
+                return;
+            }
+        }
+        if (m_options.mFollowSymlinks && alreadyVisited(directory.mFd.get()))
+        {
+            return; // a link led back into a directory that is walked already
+        }
+
+        std::vector<WalkEntry> files;
+        auto                   flush = [this, &files] {
+            if (files.empty())
+            {
+                return;
+            }
+            {
+                std::unique_lock lock(m_mutex);
+                waitForRoom(lock);
+                std::move(files.begin(), files.end(), std::back_inserter(m_found));
+            }
+            files.clear();
+            m_foundChanged.notify_one();
+        };
+
+        int dirFd = directory.mFd.get();
+        int error = detail::forEachEntry(dirFd, [&](const char* name, unsigned char type) {
+            if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0)
+            {
+                return;
+            }
+
+            // Exclusions only need the name, so they are checked before any syscall.
+            if (isExcluded(name))
+            {
+                return;
+            }
+            auto kind = detail::entryKind(dirFd, name, type, m_options.mFollowSymlinks);
+            if (kind == detail::EntryKind::OTHER)
+            {
+                return;
+            }
+
+            if (kind == detail::EntryKind::FAILED || kind == detail::EntryKind::REGULAR)
+            {
+                int entryError = kind == detail::EntryKind::FAILED ? errno : 0;
+                if (!isIncluded(name))
+                {
+                    return;
+                }
+                files.push_back({detail::joinPath(directory.mPath, name), directory.mRoot,
+                                 directory.mRootLength, entryError});
+                if (files.size() >= detail::FOUND_BATCH_SIZE)
+                {
+                    flush();
+                }
+                return;
+            }
+
+            PendingDirectory child{detail::joinPath(directory.mPath, name), directory.mRoot,
+                                   directory.mRootLength, FileDescriptor{}};
+
+            // A descriptor slot is reserved under the lock, but the open itself runs outside of
+            // it so that the walkers do not take turns for their main syscall.
+            bool reserved{false};
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_heldDescriptors < detail::MAX_HELD_DESCRIPTORS)
+                {
+                    ++m_heldDescriptors;
+                    reserved = true;
+                }
+            }
+            if (reserved)
+            {
+                int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+                if (!m_options.mFollowSymlinks)
+                {
+                    flags |= O_NOFOLLOW;
+                }
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+                child.mFd = FileDescriptor{::openat(dirFd, name, flags)};
+            }
+            {
+                std::lock_guard lock(m_mutex);
+                if (reserved && !child.mFd.valid())
+                {
+                    --m_heldDescriptors; // it is opened by path when its turn comes
+                }
+                m_directories.push_back(std::move(child));
+            }
+            m_directoriesChanged.notify_one();
+        });
+        flush();
+
+        if (error != 0)
+        {
+            std::unique_lock lock(m_mutex);
+            waitForRoom(lock);
+            m_found.push_back({directory.mPath, directory.mRoot, directory.mRootLength, error});
+            m_foundChanged.notify_one();
+        }
+    }
+
+    auto DirectoryWalker::isExcluded(const char* name) const -> bool
+    {
+        return std::any_of(m_options.mExclude.begin(), m_options.mExclude.end(),
+                           [name](const std::string& pattern) {
+                               return ::fnmatch(pattern.c_str(), name, 0) == 0;
+                           });
+    }
+
+    auto DirectoryWalker::isIncluded(const char* name) const -> bool
+    {
+        return m_options.mInclude.empty() ||
+               std::any_of(m_options.mInclude.begin(), m_options.mInclude.end(),
+                           [name](const std::string& pattern) {
+                               return ::fnmatch(pattern.c_str(), name, 0) == 0;
+                           });
+    }
+
+    auto DirectoryWalker::alreadyVisited(int fd) -> bool
+    {
+        struct stat info{};
+        if (::fstat(fd, &info) != 0)
+        {
+            return false;
+        }
+        std::lock_guard lock(m_mutex);
+        return !m_visited.emplace(info.st_dev, info.st_ino).second;
+    }
+
+    auto DirectoryWalker::next() -> std::optional<WalkEntry>
+    {
+        std::unique_lock lock(m_mutex);
+        m_foundChanged.wait(lock, [this] { return m_stopped || !m_found.empty() || finished(); });
+        if (m_found.empty())
+        {
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+            return std::nullopt;
+        }
+        WalkEntry entry = std::move(m_found.front());
+        m_found.pop_front();
+        if (m_found.size() == detail::MAX_FOUND - 1)
+        {
+            m_foundTaken.notify_all();
+        }
+        return entry;
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,218 @@
+#ifndef CCWC_ALGORITHM_DIRECTORY_WALKER_HPP
+#define CCWC_ALGORITHM_DIRECTORY_WALKER_HPP
+
+#include "file_descriptor.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Options that decide which entries a recursive walk reports.
+     */
+    struct WalkOptions
+    {
+        /**
+         * @brief Glob patterns a file name must match (any of them) to be counted; empty
+         * counts every file.
+         */
+        std::vector<std::string> mInclude;
+
+        /**
+         * @brief Glob patterns of file and directory names that are skipped.
+         */
+        std::vector<std::string> mExclude;
+
+        /**
+         * @brief Follow symbolic links found inside the walked directories.
+         */
+        bool mFollowSymlinks{false};
+    };
+
+    /**
+     * @brief A root handed to the DirectoryWalker.
+     */
+    struct WalkRoot
+    {
+        /**
+         * @brief Path of the root.
+         */
+        std::string mPath;
+
+        /**
+         * @brief Index of the root, reported back with every entry found under it.
+         */
+        std::size_t mIndex{0};
+
+        /**
+         * @brief Whether the root is looked at; a root that is not is only reported back, in
+         * its place among the other roots.
+         */
+        bool mWalk{true};
+    };
+
+    /**
+     * @brief Hands out the next root to walk, or std::nullopt once there are no more.
+     */
+    using RootSource = std::function<std::optional<WalkRoot>()>;
+
+    /**
+     * @brief A file found by the DirectoryWalker, or an entry that could not be read.
+     */
+    struct WalkEntry
+    {
+        /**
+         * @brief Path of the file, built from the root it was found under.
+         */
+        std::string mPath;
+
+        /**
+         * @brief Index of the root the entry was found under.
+         */
+        std::size_t mRoot{0};
+
+        /**
+         * @brief Length of the root's path at the start of mPath; the whole of mPath for a root
+         * reported as it is.
+         */
+        std::size_t mRootLength{0};
+
+        /**
+         * @brief The errno of a directory that could not be opened or read, or of an entry that
+         * could not be looked at, such as a dangling link (0 for files).
+         */
+        int mErrno{0};
+    };
+
+    /**
+     * @brief Walks directory trees with several threads and hands out the regular files found.
+     *
+     * Directories are opened with openat() relative to their already opened parent and listed
+     * with getdents64(), so no path is resolved twice and each directory costs a handful of
+     * syscalls. Include/exclude patterns are matched against the entry name while the directory
+     * is listed, so excluded subtrees are never opened. Files are handed out as soon as they are
+     * found, which lets the caller count them while the walk goes on; when the caller falls
+     * behind, the walkers wait, so the files found but not counted yet stay a bounded queue.
+     *
+     * The roots are taken from a RootSource whenever a walker runs out of directories, so the
+     * trees of several roots are walked by the same threads and a long list of roots is never
+     * held. Roots that are not directories are reported as they are.
+     */
+    class DirectoryWalker
+    {
+      private:
+        /**
+         * @brief A directory waiting to be listed.
+         */
+        struct PendingDirectory
+        {
+            std::string    mPath;
+            std::size_t    mRoot{0};
+            std::size_t    mRootLength{0};
+            FileDescriptor mFd; // Opened by the parent; invalid if it has to be opened by path.
+        };
+
+        RootSource                                        m_roots;
+        WalkOptions                                       m_options;
+        std::deque<PendingDirectory>                      m_directories;
+        std::deque<WalkEntry>                             m_found;
+        std::set<std::pair<std::uint64_t, std::uint64_t>> m_visited;
+        std::size_t                                       m_busy{0};
+        std::size_t                                       m_heldDescriptors{0};
+        bool                                              m_takingRoot{false};
+        bool                                              m_rootsDone{false};
+        std::exception_ptr                                m_error;
+        bool                                              m_stopped{false};
+        std::mutex                                        m_mutex;
+        std::condition_variable                           m_directoriesChanged;
+        std::condition_variable                           m_foundChanged;
+        std::condition_variable                           m_foundTaken;
+        std::vector<std::jthread>                         m_workers;
+
+        /**
+         * @brief Body of a walker thread.
+         */
+        auto run() -> void;
+
+        /**
+         * @brief Take the next root from the source and queue it; called with `lock` held, which
+         * is released while the source is read.
+         */
+        auto takeRoot(std::unique_lock<std::mutex>& lock) -> void;
+
+        /**
+         * @brief Whether every root was taken and walked; called with the lock held.
+         */
+        [[nodiscard]] auto finished() const -> bool
+        {
+            return m_rootsDone && m_busy == 0 && m_directories.empty();
+        }
+
+        /**
+         * @brief Wait until the consumer has taken enough files for more to be reported.
+         */
+        auto waitForRoom(std::unique_lock<std::mutex>& lock) -> void;
+
+        /**
+         * @brief List one directory, queueing its subdirectories and reporting its files.
+         */
+        auto walk(PendingDirectory& directory) -> void;
+
+        /**
+         * @brief Whether a file or directory name matches an exclude pattern.
+         */
+        [[nodiscard]] auto isExcluded(const char* name) const -> bool;
+
+        /**
+         * @brief Whether a file name matches an include pattern (or none were given).
+         */
+        [[nodiscard]] auto isIncluded(const char* name) const -> bool;
+
+        /**
+         * @brief Whether a directory was already walked; only tracked when following links.
+         */
+        auto alreadyVisited(int fd) -> bool;
+
+      public:
+        /**
+         * @brief Constructor, starts walking right away.
+         * @param roots The paths to walk; it is only called by one walker thread at a time.
+         * @param options Which entries to report.
+         * @param threadCount Number of walker threads; 0 picks one per core (at most 8).
+         */
+        DirectoryWalker(RootSource roots, WalkOptions options, std::size_t threadCount = 0);
+
+        /**
+         * @brief Destructor: stops the walk.
+         */
+        ~DirectoryWalker();
+
+        DirectoryWalker(const DirectoryWalker&)                    = delete;
+        auto operator=(const DirectoryWalker&) -> DirectoryWalker& = delete;
+        DirectoryWalker(DirectoryWalker&&)                         = delete;
+        auto operator=(DirectoryWalker&&) -> DirectoryWalker&      = delete;
+
+        /**
+         * @brief Take the next file found, blocking until one is found.
+         * @return The next entry, or std::nullopt once every tree was walked.
+         * @throws Whatever the root source threw, once the entries found before are taken.
+         */
+        auto next() -> std::optional<WalkEntry>;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_DIRECTORY_WALKER_HPP
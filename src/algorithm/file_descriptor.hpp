@@ -0,0 +1,94 @@
+#ifndef CCWC_ALGORITHM_FILE_DESCRIPTOR_HPP
+#define CCWC_ALGORITHM_FILE_DESCRIPTOR_HPP
+
+#include <unistd.h>
+#include <utility>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Owning wrapper around a POSIX file descriptor.
+     *
+     * The descriptor is closed when the wrapper goes out of scope. It is movable but not copyable
+     * so that exactly one owner is responsible for closing it.
+     */
+    class FileDescriptor
+    {
+      private:
+        /**
+         * @brief The owned descriptor, or -1 if nothing is owned.
+         */
+        int m_fd{-1};
+
+      public:
+        /**
+         * @brief Constructor for an empty (invalid) descriptor.
+         */
+        FileDescriptor() = default;
+
+        /**
+         * @brief Take ownership of an already opened descriptor.
+         * @param fd The descriptor to own.
+         */
+        explicit FileDescriptor(int fd) : m_fd(fd)
+        {
+        }
+
+        /**
+         * @brief Destructor, closes the descriptor if one is owned.
+         */
+        ~FileDescriptor()
+        {
+            if (m_fd >= 0)
+            {
+                ::close(m_fd);
+            }
+        }
+
+        FileDescriptor(const FileDescriptor&)                    = delete;
+        auto operator=(const FileDescriptor&) -> FileDescriptor& = delete;
+
+        /**
+         * @brief Move constructor, leaves the source empty.
+         */
+        FileDescriptor(FileDescriptor&& other) noexcept : m_fd(std::exchange(other.m_fd, -1))
+        {
+        }
+
+        /**
+         * @brief Move assignment, closes the currently owned descriptor first.
+         */
+        auto operator=(FileDescriptor&& other) noexcept -> FileDescriptor&
+        {
+            if (this != &other)
+            {
+                if (m_fd >= 0)
+                {
+                    ::close(m_fd);
+                }
+                m_fd = std::exchange(other.m_fd, -1);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Get the raw descriptor.
+         */
+        [[nodiscard]] auto get() const noexcept -> int
+        {
+            return m_fd;
+        }
+
+        /**
+         * @brief Returns true if a descriptor is owned.
+         */
+        [[nodiscard]] auto valid() const noexcept -> bool
+        {
+            return m_fd >= 0;
+        }
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_FILE_DESCRIPTOR_HPP
@@ -0,0 +1,305 @@
+#include "file_follower.hpp"
+
+#include "exception/exception.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string_view>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+#ifdef __linux__
+        constexpr std::uint32_t DIRECTORY_EVENTS = IN_CREATE | IN_MOVED_TO;
+        constexpr std::uint32_t FILE_EVENTS =
+            IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+#else
+        constexpr std::uint32_t DIRECTORY_EVENTS = 0;
+        constexpr std::uint32_t FILE_EVENTS      = 0;
+#endif
+
+        /**
+         * @brief The directory a path is in.
+         */
+        auto directoryOf(const std::string& path) -> std::string
+        {
+            std::size_t separator = path.rfind('/');
+            if (separator == std::string::npos)
+            {
+                return ".";
+            }
+            return separator == 0 ? "/" : path.substr(0, separator);
+        }
+
+        /**
+         * @brief The name of a path inside its directory.
+         */
+        auto entryNameOf(const std::string& path) -> std::string
+        {
+            std::size_t separator = path.rfind('/');
+            return separator == std::string::npos ? path : path.substr(separator + 1);
+        }
+    } // namespace detail
+
+    FileFollower::FileFollower(std::vector<ccwc::argument_parser::InputDataObject>& inputs,
+                               std::chrono::milliseconds                            interval)
+        : m_inputs(inputs), m_files(inputs.size()), m_interval(interval),
+          m_stateMachine(buildCounterStateMachineChain())
+    {
+#ifdef __linux__
+        m_notify = FileDescriptor{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)};
+#endif
+        for (std::size_t index = 0; index < m_files.size(); ++index)
+        {
+            m_files[index].mEntryName      = detail::entryNameOf(m_inputs[index].mName);
+            m_files[index].mDirectoryWatch =
+                watch(detail::directoryOf(m_inputs[index].mName), detail::DIRECTORY_EVENTS, index);
+            reopen(index);
+        }
+    }
+
+    auto FileFollower::watch(const std::string& path, std::uint32_t mask, std::size_t index) -> int
+    {
+        if (!m_notify.valid())
+        {
+            return -1;
+        }
+#ifdef __linux__
+        int watch = ::inotify_add_watch(m_notify.get(), path.c_str(), mask);
+        if (watch >= 0)
+        {
+            m_watchers[watch].push_back(index);
+        }
+        return watch;
+#else
+        return -1;
+#endif
+    }
+
+    auto FileFollower::unwatch(int& watch, std::size_t index) -> void
+    {
+        auto watchers = m_watchers.find(watch);
+        if (watchers == m_watchers.end())
+        {
+            watch = -1;
+            return;
+        }
+        std::erase(watchers->second, index);
+        if (watchers->second.empty())
+        {
+#ifdef __linux__
+            ::inotify_rm_watch(m_notify.get(), watch);
+#endif
+            m_watchers.erase(watchers);
+        }
+        watch = -1;
+    }
+
+    auto FileFollower::reopen(std::size_t index) -> bool
+    {
+        FollowedFile& file  = m_files[index];
+        auto&         input = m_inputs[index];
+
+        unwatch(file.mWatch, index);
+        file.mFd    = FileDescriptor{};
+        file.mCount = AppendCount{};
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        FileDescriptor fd{::open(input.mName.c_str(), O_RDONLY | O_CLOEXEC)};
+        struct stat    info{};
+        if (!fd.valid() || ::fstat(fd.get(), &info) != 0)
+        {
+            input.mHealthStatus = ccwc::argument_parser::HealthStatus(errno);
+            return false;
+        }
+        file.mFd            = std::move(fd);
+        file.mDevice        = static_cast<std::uint64_t>(info.st_dev);
+        file.mInode         = static_cast<std::uint64_t>(info.st_ino);
+        file.mWatch         = watch(input.mName, detail::FILE_EVENTS, index);
+        input.mHealthStatus = ccwc::argument_parser::HealthStatus();
+        return true;
+    }
+
+    auto FileFollower::drain(std::size_t index) -> bool
+    {
+        FollowedFile& file  = m_files[index];
+        auto&         input = m_inputs[index];
+        try
+        {
+            return countAppended(input.mName, file.mFd.get(), file.mCount, *m_stateMachine);
+        }
+        catch (const ccwc::exception::FileOperationException& e)
+        {
+            m_stateMachine->reset();
+            input.mHealthStatus = ccwc::argument_parser::HealthStatus(false, e.what());
+            return true;
+        }
+    }
+
+    auto FileFollower::carryOver(std::size_t index) -> void
+    {
+        FollowedFile& file = m_files[index];
+        file.mEarlier += file.mCount.total(*m_stateMachine);
+        file.mCount = AppendCount{};
+    }
+
+    auto FileFollower::refresh(std::size_t index) -> bool
+    {
+        FollowedFile& file       = m_files[index];
+        auto&         input      = m_inputs[index];
+        bool          wasHealthy = input.mHealthStatus.mIsHealthy;
+        bool          restarted  = false;
+
+        // A different file behind the name means the old one was rotated away. Until the new
+        // file appears, the old one is still read, as it may be written to for a while.
+        struct stat info{};
+        bool        exists   = ::stat(input.mName.c_str(), &info) == 0;
+        bool        replaced = exists && (file.mDevice != static_cast<std::uint64_t>(info.st_dev) ||
+                                          file.mInode != static_cast<std::uint64_t>(info.st_ino));
+        if (file.mFd.valid() && replaced)
+        {
+            // What was written to the old file since the last look is still counted.
+            drain(index);
+            carryOver(index);
+        }
+        if (!file.mFd.valid() || replaced)
+        {
+            if (!reopen(index))
+            {
+                return wasHealthy || replaced;
+            }
+            restarted = true;
+        }
+
+        if (::fstat(file.mFd.get(), &info) == 0 &&
+            static_cast<std::uint64_t>(info.st_size) < file.mCount.mOffset)
+        {
+            carryOver(index); // truncated, e.g. by copytruncate log rotation
+            restarted = true;
+        }
+
+        bool grown = drain(index);
+        return grown || restarted || !wasHealthy;
+    }
+
+    auto FileFollower::collectEvents(std::chrono::milliseconds timeout) -> void
+    {
+        if (!m_notify.valid())
+        {
+            // Nothing tells us what changed: look at every file once per interval.
+            if (timeout.count() < 0)
+            {
+                std::this_thread::sleep_for(m_interval);
+            }
+            for (auto& file : m_files)
+            {
+                file.mDirty = true;
+            }
+            return;
+        }
+
+#ifdef __linux__
+        pollfd waiting{m_notify.get(), POLLIN, 0};
+        if (::poll(&waiting, 1, static_cast<int>(timeout.count())) <= 0)
+        {
+            return;
+        }
+
+        alignas(inotify_event) std::array<char, 4096> buffer{}; // NOLINT(*-magic-numbers)
+        while (true)
+        {
+            ssize_t bytesRead = ::read(m_notify.get(), buffer.data(), buffer.size());
+            if (bytesRead <= 0)
+            {
+                return; // EAGAIN: drained
+            }
+            for (std::size_t offset = 0; offset < static_cast<std::size_t>(bytesRead);)
+            {
+                inotify_event event{};
+                std::memcpy(&event, buffer.data() + offset, sizeof(event));
+                offset += sizeof(event) + event.len;
+
+                auto watchers = m_watchers.find(event.wd);
+                if (watchers == m_watchers.end())
+                {
+                    continue; // IN_IGNORED of a removed watch
+                }
+                // A directory event names the entry that was created or moved in; only the file
+                // followed under that name is affected.
+                // NOLINTNEXTLINE(*-pointer-arithmetic)
+                const char*      entry = buffer.data() + offset - event.len;
+                std::string_view entryName(entry, ::strnlen(entry, event.len));
+                for (std::size_t index : watchers->second)
+                {
+                    FollowedFile& file = m_files[index];
+                    if (file.mDirectoryWatch != event.wd || entryName == file.mEntryName)
+                    {
+                        file.mDirty = true;
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    auto FileFollower::update() -> bool
+    {
+        bool changed = false;
+        for (std::size_t index = 0; index < m_files.size(); ++index)
+        {
+            if (m_files[index].mDirty)
+            {
+                m_files[index].mDirty = false;
+                changed               = refresh(index) || changed;
+            }
+        }
+        return changed;
+    }
+
+    auto FileFollower::results() const -> ResultStore
+    {
+        ResultStore results;
+        results.reserve(m_files.size());
+        for (std::size_t index = 0; index < m_files.size(); ++index)
+        {
+            Counter counter = m_files[index].mEarlier;
+            counter += m_files[index].mCount.total(*m_stateMachine);
+            results.add(m_inputs[index], counter);
+        }
+        return results;
+    }
+
+    auto FileFollower::run(const std::function<void(const ResultStore&)>& report) -> void
+    {
+        constexpr std::chrono::milliseconds WAIT_FOREVER{-1};
+
+        update();
+        report(results());
+        while (true)
+        {
+            auto reported = std::chrono::steady_clock::now();
+            collectEvents(WAIT_FOREVER);
+
+            // Bound the report rate: a busy file is read once per interval, not once per write.
+            std::this_thread::sleep_until(reported + m_interval);
+            collectEvents(std::chrono::milliseconds{0});
+            if (update())
+            {
+                report(results());
+            }
+        }
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,139 @@
+#ifndef CCWC_ALGORITHM_FILE_FOLLOWER_HPP
+#define CCWC_ALGORITHM_FILE_FOLLOWER_HPP
+
+#include "argument_parser/input_objects.hpp"
+#include "counter.hpp"
+#include "counter_state_machine.hpp"
+#include "file_descriptor.hpp"
+#include "incremental_counter.hpp"
+#include "result_store.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Shortest time between two reports of `--follow`.
+     */
+    constexpr std::chrono::milliseconds DEFAULT_FOLLOW_INTERVAL{1000};
+
+    /**
+     * @brief Keeps files open and counts what is appended to them, like `tail -F`.
+     *
+     * Each file is watched with inotify (IN_MODIFY and friends) and so is its directory, to
+     * notice a file being created or renamed over the followed name. When a file changes, only
+     * the bytes appended since the last look are read and added to its counts. A file that was
+     * replaced (log rotation) is read to its end before the new file is opened, and a file
+     * truncated below what was read is counted again from its start; either way the counts
+     * carry on from what was counted before, so they cover everything written under the name
+     * and never go backwards. A file that does not exist yet is followed from the moment it
+     * appears.
+     *
+     * Without inotify the files are checked once per interval instead.
+     */
+    class FileFollower
+    {
+      private:
+        /**
+         * @brief The open file behind an input and what was counted of it.
+         */
+        struct FollowedFile
+        {
+            FileDescriptor mFd;
+            std::uint64_t  mDevice{0};
+            std::uint64_t  mInode{0};
+            AppendCount    mCount;
+            Counter        mEarlier;            // Counts of the files rotated or truncated away.
+            std::string    mEntryName;          // Name inside its directory, for its events.
+            int            mWatch{-1};          // inotify watch on the file.
+            int            mDirectoryWatch{-1}; // inotify watch on its directory.
+            bool           mDirty{true};
+        };
+
+        std::vector<ccwc::argument_parser::InputDataObject>& m_inputs;
+        std::vector<FollowedFile>                            m_files;
+        std::map<int, std::vector<std::size_t>>              m_watchers; // watch -> files
+        FileDescriptor                                       m_notify;
+        std::chrono::milliseconds                            m_interval;
+        std::unique_ptr<CounterStateMachine>                 m_stateMachine;
+
+        /**
+         * @brief Add an inotify watch on `path` for the file at `index`.
+         * @return The watch, or -1.
+         */
+        auto watch(const std::string& path, std::uint32_t mask, std::size_t index) -> int;
+
+        /**
+         * @brief Drop the inotify watch `watch` of the file at `index`.
+         */
+        auto unwatch(int& watch, std::size_t index) -> void;
+
+        /**
+         * @brief Open the file at `index` (again) and count it from its start.
+         * @return Whether the file could be opened.
+         */
+        auto reopen(std::size_t index) -> bool;
+
+        /**
+         * @brief Bring the counts of the file at `index` up to date.
+         * @return Whether its counts or its health changed.
+         */
+        auto refresh(std::size_t index) -> bool;
+
+        /**
+         * @brief Read the file at `index` up to its current end.
+         * @return Whether any byte was appended.
+         */
+        auto drain(std::size_t index) -> bool;
+
+        /**
+         * @brief Move the counts of the file at `index` to its earlier counts, before it is
+         * counted again from its start.
+         */
+        auto carryOver(std::size_t index) -> void;
+
+        /**
+         * @brief Mark the files named by pending inotify events as dirty.
+         * @param timeout How long to wait for the first event; negative waits forever.
+         */
+        auto collectEvents(std::chrono::milliseconds timeout) -> void;
+
+      public:
+        /**
+         * @brief Constructor: opens and watches the inputs.
+         * @param inputs The files to follow; their health is updated as they come and go.
+         * @param interval Shortest time between two reports.
+         */
+        FileFollower(std::vector<ccwc::argument_parser::InputDataObject>& inputs,
+                     std::chrono::milliseconds                            interval);
+
+        /**
+         * @brief Bring the counts of every changed file up to date.
+         * @return Whether anything changed since the last update.
+         */
+        auto update() -> bool;
+
+        /**
+         * @brief The current counts of every input.
+         */
+        [[nodiscard]] auto results() const -> ResultStore;
+
+        /**
+         * @brief Report the counts, then report them again every time they change, at most
+         * once per interval. Does not return.
+         * @param report Called with the counts of every input.
+         */
+        [[noreturn]] auto run(const std::function<void(const ResultStore&)>& report) -> void;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_FILE_FOLLOWER_HPP
@@ -0,0 +1,412 @@
+#include "incremental_counter.hpp"
+
+#include "counter_state_machine.hpp"
+#include "exception/exception.hpp"
+#include "segment_counter.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <span>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr const char*   CHECKPOINT_MAGIC      = "ccwc-checkpoint";
+        constexpr int           CHECKPOINT_VERSION    = 1;
+        constexpr std::size_t   FINGERPRINT_SIZE      = 4096;
+        constexpr std::size_t   INCREMENTAL_READ_SIZE = static_cast<std::size_t>(1024 * 1024);
+        constexpr std::size_t   MAX_UTF8_SEQUENCE     = 4;
+        constexpr std::uint64_t FNV_OFFSET_BASIS      = 0xcbf29ce484222325ULL;
+        constexpr std::uint64_t FNV_PRIME             = 0x100000001b3ULL;
+
+        /**
+         * @brief Everything needed to continue counting a file where it was left.
+         */
+        struct Checkpoint
+        {
+            std::uint64_t mDevice{0};
+            std::uint64_t mInode{0};
+            AppendCount   mCount;
+            std::uint64_t mHeadHash{0}; // Fingerprint of the first 4KiB.
+            std::uint64_t mTailHash{0}; // Fingerprint of the 4KiB before the offset.
+        };
+
+        auto fnv1a(const unsigned char* data, std::size_t size,
+                   std::uint64_t hash = FNV_OFFSET_BASIS) -> std::uint64_t
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ data[i]) * FNV_PRIME; // NOLINT(*-pointer-arithmetic)
+            }
+            return hash;
+        }
+
+        /**
+         * @brief Read exactly `size` bytes at `offset`.
+         * @return False if the file is shorter or cannot be read.
+         */
+        auto preadAll(int fd, unsigned char* data, std::size_t size, std::uint64_t offset) -> bool
+        {
+            while (size > 0)
+            {
+                ssize_t bytesRead = ::pread(fd, data, size, static_cast<off_t>(offset));
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (bytesRead <= 0)
+                {
+                    return false;
+                }
+                data += bytesRead; // NOLINT(*-pointer-arithmetic)
+                size -= static_cast<std::size_t>(bytesRead);
+                offset += static_cast<std::uint64_t>(bytesRead);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Fingerprint `size` bytes at `offset`, or std::nullopt if they cannot be read.
+         */
+        auto fingerprint(int fd, std::uint64_t offset, std::size_t size)
+            -> std::optional<std::uint64_t>
+        {
+            std::vector<unsigned char> data(size);
+            if (!preadAll(fd, data.data(), size, offset))
+            {
+                return std::nullopt;
+            }
+            return fnv1a(data.data(), data.size());
+        }
+
+        auto headSpan(std::uint64_t offset) -> std::size_t
+        {
+            return static_cast<std::size_t>(std::min<std::uint64_t>(offset, FINGERPRINT_SIZE));
+        }
+
+        /**
+         * @brief The checkpoint file of an input: named after a hash of its absolute path.
+         */
+        auto checkpointPath(const std::string& directory, const std::string& filename)
+            -> std::string
+        {
+            std::string absolute = filename;
+            if (char* resolved = ::realpath(filename.c_str(), nullptr))
+            {
+                absolute = resolved;
+                std::free(resolved); // NOLINT(*-no-malloc, *-owning-memory)
+            }
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            auto hash = fnv1a(reinterpret_cast<const unsigned char*>(absolute.data()),
+                              absolute.size());
+
+            std::ostringstream path;
+            path << directory << '/' << std::hex << std::setw(16) << std::setfill('0') << hash
+                 << ".ckpt";
+            return path.str();
+        }
+
+        auto loadCheckpoint(const std::string& path) -> std::optional<Checkpoint>
+        {
+            std::ifstream file(path);
+            std::string   magic;
+            int           version{0};
+            if (!(file >> magic >> version) || magic != CHECKPOINT_MAGIC ||
+                version != CHECKPOINT_VERSION)
+            {
+                return std::nullopt;
+            }
+
+            Checkpoint   checkpoint;
+            AppendCount& count   = checkpoint.mCount;
+            Counter&     counter = count.mCounted.mCounter;
+            unsigned    first{0};
+            unsigned    last{0};
+            std::string pending;
+            file >> checkpoint.mDevice >> checkpoint.mInode >> count.mOffset >> counter.bytes >>
+                counter.words >> counter.lines >> counter.multibyte >> first >> last >>
+                count.mCounted.mEmpty >> checkpoint.mHeadHash >> checkpoint.mTailHash >> pending;
+            if (!file)
+            {
+                return std::nullopt;
+            }
+            count.mCounted.mFirst = static_cast<unsigned char>(first);
+            count.mCounted.mLast  = static_cast<unsigned char>(last);
+
+            // The pending bytes are written as hex, "-" when there are none. A checkpoint that
+            // does not parse is treated as missing, so the file is counted again.
+            if (pending == "-")
+            {
+                return checkpoint;
+            }
+            if (pending.size() % 2 != 0 || pending.size() >= 2 * MAX_UTF8_SEQUENCE)
+            {
+                return std::nullopt; // an unfinished character has at most 3 bytes
+            }
+            for (std::size_t i = 0; i < pending.size(); i += 2)
+            {
+                constexpr int HEX = 16;
+                unsigned      byte{0};
+                const char*   begin = pending.data() + i; // NOLINT(*-pointer-arithmetic)
+                auto [end, error]   = std::from_chars(begin, begin + 2, byte, HEX);
+                if (error != std::errc() || end != begin + 2)
+                {
+                    return std::nullopt;
+                }
+                count.mPending.push_back(static_cast<unsigned char>(byte));
+            }
+            return checkpoint;
+        }
+
+        /**
+         * @brief Write the checkpoint to a temporary file and rename it into place.
+         */
+        auto saveCheckpoint(const std::string& directory, const std::string& path,
+                            const Checkpoint& checkpoint) -> void
+        {
+            ::mkdir(directory.c_str(), 0777); // NOLINT(*-magic-numbers)
+
+            const AppendCount& count   = checkpoint.mCount;
+            const Counter&     counter = count.mCounted.mCounter;
+            std::ostringstream line;
+            line << CHECKPOINT_MAGIC << ' ' << CHECKPOINT_VERSION << ' ' << checkpoint.mDevice
+                 << ' ' << checkpoint.mInode << ' ' << count.mOffset << ' ' << counter.bytes
+                 << ' ' << counter.words << ' ' << counter.lines << ' ' << counter.multibyte
+                 << ' ' << static_cast<unsigned>(count.mCounted.mFirst) << ' '
+                 << static_cast<unsigned>(count.mCounted.mLast) << ' ' << count.mCounted.mEmpty
+                 << ' ' << checkpoint.mHeadHash << ' ' << checkpoint.mTailHash << ' ';
+            if (count.mPending.empty())
+            {
+                line << '-';
+            }
+            for (unsigned char byte : count.mPending)
+            {
+                line << std::hex << std::setw(2) << std::setfill('0')
+                     << static_cast<unsigned>(byte);
+            }
+            line << '\n';
+
+            std::string temporary = path + ".tmp" + std::to_string(::getpid());
+            {
+                std::ofstream file(temporary, std::ios::trunc);
+                file << line.str();
+                if (!file.flush())
+                {
+                    std::remove(temporary.c_str());
+                    return; // the checkpoint only saves work next time
+                }
+            }
+            std::rename(temporary.c_str(), path.c_str());
+        }
+
+        /**
+         * @brief The chain the appended bytes are counted with, built once per counting thread
+         * rather than once per file; countSegment() resets it around every segment.
+         */
+        auto checkpointStateMachine() -> CounterStateMachine&
+        {
+            static thread_local std::unique_ptr<CounterStateMachine> stateMachine =
+                buildCounterStateMachineChain();
+            return *stateMachine;
+        }
+
+        /**
+         * @brief Forwards to the stream of a file but counts it from its checkpoint.
+         */
+        class IncrementalFileInputStream : public UniversalInputStream
+        {
+          private:
+            std::unique_ptr<UniversalInputStream> m_stream;
+            FileDescriptor                        m_fd;
+            std::string                           m_directory;
+
+            /**
+             * @brief Whether the checkpoint still describes the start of this file.
+             */
+            [[nodiscard]] auto matches(const Checkpoint& checkpoint, const struct stat& info) const
+                -> bool
+            {
+                if (checkpoint.mDevice != static_cast<std::uint64_t>(info.st_dev) ||
+                    checkpoint.mInode != static_cast<std::uint64_t>(info.st_ino) ||
+                    checkpoint.mCount.mOffset > static_cast<std::uint64_t>(info.st_size))
+                {
+                    return false; // rotated or truncated
+                }
+                std::uint64_t offset = checkpoint.mCount.mOffset;
+                std::size_t   span   = headSpan(offset);
+                return fingerprint(m_fd.get(), 0, span) == checkpoint.mHeadHash &&
+                       fingerprint(m_fd.get(), offset - span, span) == checkpoint.mTailHash;
+            }
+
+          public:
+            IncrementalFileInputStream(std::unique_ptr<UniversalInputStream> stream,
+                                       FileDescriptor fd, std::string directory)
+                : m_stream(std::move(stream)), m_fd(std::move(fd)),
+                  m_directory(std::move(directory))
+            {
+            }
+
+            ~IncrementalFileInputStream() override = default;
+
+            IncrementalFileInputStream(const IncrementalFileInputStream&) = delete;
+            IncrementalFileInputStream(IncrementalFileInputStream&&)      = delete;
+            auto operator=(const IncrementalFileInputStream&)
+                -> IncrementalFileInputStream& = delete;
+            auto operator=(IncrementalFileInputStream&&) -> IncrementalFileInputStream& = delete;
+
+            [[nodiscard]] auto name() const -> std::string override
+            {
+                return m_stream->name();
+            }
+
+            [[nodiscard]] auto isStdin() const -> bool override
+            {
+                return false;
+            }
+
+            auto nextByte() -> std::optional<unsigned char> override
+            {
+                return m_stream->nextByte();
+            }
+
+            auto reset() -> bool override
+            {
+                return m_stream->reset();
+            }
+
+            [[nodiscard]] auto good() const -> bool override
+            {
+                return m_stream->good();
+            }
+
+            /**
+             * @brief The appended bytes are read with pread() by countAll().
+             */
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "pread";
+            }
+
+            [[nodiscard]] auto kernel() const -> std::string_view override
+            {
+                return "checkpoint";
+            }
+
+            auto countAll() -> std::optional<Counter> override
+            {
+                struct stat info{};
+                if (::fstat(m_fd.get(), &info) != 0)
+                {
+                    return std::nullopt;
+                }
+
+                std::string path       = checkpointPath(m_directory, name());
+                auto        checkpoint = loadCheckpoint(path);
+                if (!checkpoint.has_value() || !matches(checkpoint.value(), info))
+                {
+                    checkpoint = Checkpoint{};
+                }
+                Checkpoint& state = checkpoint.value();
+                state.mDevice     = static_cast<std::uint64_t>(info.st_dev);
+                state.mInode      = static_cast<std::uint64_t>(info.st_ino);
+
+                CounterStateMachine& stateMachine = checkpointStateMachine();
+                countAppended(name(), m_fd.get(), state.mCount, stateMachine);
+
+                std::uint64_t offset = state.mCount.mOffset;
+                std::size_t   span   = headSpan(offset);
+                state.mHeadHash      = fingerprint(m_fd.get(), 0, span).value_or(0);
+                state.mTailHash      = fingerprint(m_fd.get(), offset - span, span).value_or(0);
+                saveCheckpoint(m_directory, path, state);
+
+                return state.mCount.total(stateMachine);
+            }
+        };
+    } // namespace detail
+
+    auto AppendCount::total(CounterStateMachine& stateMachine) const -> Counter
+    {
+        SegmentCount whole = mCounted;
+        whole.append(countSegment(mPending, stateMachine));
+        return whole.mCounter;
+    }
+
+    auto countChunk(const ChunkReader& read, AppendCount& count, CounterStateMachine& stateMachine,
+                    std::vector<unsigned char>& buffer) -> ssize_t
+    {
+        buffer.resize(detail::INCREMENTAL_READ_SIZE + detail::MAX_UTF8_SEQUENCE);
+        std::copy(count.mPending.begin(), count.mPending.end(), buffer.begin());
+        std::size_t carried = count.mPending.size();
+
+        ssize_t bytesRead = read(buffer.data() + carried, detail::INCREMENTAL_READ_SIZE,
+                                 count.mOffset);
+        if (bytesRead <= 0)
+        {
+            return bytesRead;
+        }
+        count.mOffset += static_cast<std::uint64_t>(bytesRead);
+
+        std::span<const unsigned char> chunk(buffer.data(),
+                                             carried + static_cast<std::size_t>(bytesRead));
+        std::size_t keep     = trailingIncompleteUtf8(chunk);
+        auto        complete = chunk.first(chunk.size() - keep);
+        TraceSpan   span("count");
+        span.setBytes(complete.size());
+        count.mCounted.append(countSegment(complete, stateMachine));
+        count.mPending.assign(complete.end(), chunk.end());
+        return bytesRead;
+    }
+
+    auto countAppended(const std::string& name, int fd, AppendCount& count,
+                       CounterStateMachine& stateMachine) -> bool
+    {
+        auto readAt = [fd, &name](unsigned char* data, std::size_t size, std::uint64_t offset) {
+            TraceSpan span("read", name);
+            ssize_t   bytesRead = ::pread(fd, data, size, static_cast<off_t>(offset));
+            span.setBytes(bytesRead > 0 ? static_cast<std::uint64_t>(bytesRead) : 0);
+            return bytesRead;
+        };
+
+        std::uint64_t              start = count.mOffset;
+        std::vector<unsigned char> buffer;
+        while (true)
+        {
+            ssize_t bytesRead = countChunk(readAt, count, stateMachine, buffer);
+            if (bytesRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytesRead < 0)
+            {
+                throw ccwc::exception::FileOperationException(name + ": " + std::strerror(errno));
+            }
+            if (bytesRead == 0)
+            {
+                return count.mOffset != start;
+            }
+        }
+    }
+
+    auto createIncrementalInputStream(std::unique_ptr<UniversalInputStream> stream,
+                                      FileDescriptor fd, std::string checkpointDirectory)
+        -> std::unique_ptr<UniversalInputStream>
+    {
+        return std::make_unique<detail::IncrementalFileInputStream>(
+            std::move(stream), std::move(fd), std::move(checkpointDirectory));
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,94 @@
+#ifndef CCWC_ALGORITHM_INCREMENTAL_COUNTER_HPP
+#define CCWC_ALGORITHM_INCREMENTAL_COUNTER_HPP
+
+#include "counter_state_machine.hpp"
+#include "file_descriptor.hpp"
+#include "segment_counter.hpp"
+#include "universal_input_stream.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Counts of the first `mOffset` bytes of a file that is appended to.
+     */
+    struct AppendCount
+    {
+        std::uint64_t              mOffset{0};
+        SegmentCount               mCounted; // Counts of [0, mOffset - pending).
+        std::vector<unsigned char> mPending; // Unfinished UTF-8 character at mOffset.
+
+        /**
+         * @brief The counter of the bytes up to mOffset.
+         *
+         * The unfinished character is counted as it is, like at the end of any input.
+         */
+        [[nodiscard]] auto total(CounterStateMachine& stateMachine) const -> Counter;
+    };
+
+    /**
+     * @brief Reads up to `size` bytes at an offset into `data`, like pread(): returns the bytes
+     * read, 0 at the end of the input, or -1 with errno set.
+     */
+    using ChunkReader = std::function<ssize_t(unsigned char*, std::size_t, std::uint64_t)>;
+
+    /**
+     * @brief Read the next chunk after `count.mOffset` and add it to the counts.
+     *
+     * The chunk is cut before an unfinished UTF-8 character, which is carried over to the next
+     * chunk (or kept in `count.mPending`).
+     *
+     * @param read Reads the chunk; it is called once.
+     * @param count The counts so far, extended in place.
+     * @param stateMachine The chain to count with.
+     * @param buffer Scratch space, reused across calls.
+     * @return What `read` returned.
+     */
+    auto countChunk(const ChunkReader& read, AppendCount& count, CounterStateMachine& stateMachine,
+                    std::vector<unsigned char>& buffer) -> ssize_t;
+
+    /**
+     * @brief Count what was appended to a file after `count.mOffset`, up to its current end.
+     *
+     * The file is read with pread() in chunks of 1MiB, see countChunk().
+     *
+     * @param name Name of the file, for error messages.
+     * @param fd Descriptor of the file.
+     * @param count The counts so far, extended in place.
+     * @param stateMachine The chain to count with.
+     * @return Whether any byte was appended.
+     * @throws ccwc::exception::FileOperationException if the file cannot be read.
+     */
+    auto countAppended(const std::string& name, int fd, AppendCount& count,
+                       CounterStateMachine& stateMachine) -> bool;
+
+    /**
+     * @brief Wrap the stream of a regular file so that it is counted incrementally.
+     *
+     * The counts of the file, the offset they cover and the state at that offset (whether a
+     * word is open, the bytes of an unfinished UTF-8 character) are saved in a checkpoint file
+     * inside `checkpointDirectory`. The next count only reads what was appended after that
+     * offset and adds it to the saved counts. The checkpoint is discarded, and the file counted
+     * from the start, if the file was replaced (device/inode), truncated below the offset, or
+     * its content up to the offset no longer matches a fingerprint of the first and last 4KiB.
+     *
+     * @param stream The stream of the file, used when the file is read byte by byte.
+     * @param fd A descriptor on the same file, read with pread().
+     * @param checkpointDirectory Directory holding the checkpoint files.
+     * @return The wrapping stream.
+     */
+    auto createIncrementalInputStream(std::unique_ptr<UniversalInputStream> stream,
+                                      FileDescriptor fd, std::string checkpointDirectory)
+        -> std::unique_ptr<UniversalInputStream>;
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_INCREMENTAL_COUNTER_HPP
@@ -0,0 +1,189 @@
+#include "input_prefetcher.hpp"
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <sys/resource.h>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        /**
+         * @brief Default number of inputs opened ahead of the counting stage.
+         */
+        constexpr std::size_t DEFAULT_MAX_OPEN_INPUTS = 16;
+
+        /**
+         * @brief Pick the default bound, leaving most of the descriptor limit to everything
+         * else (decoders, file lists, output).
+         */
+        auto defaultMaxOpen() -> std::size_t
+        {
+            constexpr rlim_t DESCRIPTOR_SHARE = 4;
+
+            rlimit limit{};
+            if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+            {
+                return std::clamp<std::size_t>(limit.rlim_cur / DESCRIPTOR_SHARE, 1,
+                                               DEFAULT_MAX_OPEN_INPUTS);
+            }
+            return DEFAULT_MAX_OPEN_INPUTS;
+        }
+    } // namespace detail
+
+    auto openInput(const ccwc::argument_parser::InputDataObject& input,
+                   const InputStreamOptions& options, const ResultCache* cache) -> OpenedInput
+    {
+        TraceSpan   span("open", input.mName);
+        OpenedInput opened;
+        if (!input.mHealthStatus.mIsHealthy)
+        {
+            opened.mHealthStatus = input.mHealthStatus;
+            return opened;
+        }
+
+        if (input.mIsStdin)
+        {
+            opened.mStream = createInputStream(options);
+            return opened;
+        }
+
+        if (cache != nullptr)
+        {
+            // Unchanged files are answered from their metadata alone.
+            auto key = ResultCache::keyFor(input.mName, options.mDecompress);
+            if (key.has_value())
+            {
+                opened.mCached = cache->lookup(key.value());
+                if (opened.mCached.has_value())
+                {
+                    return opened;
+                }
+            }
+        }
+
+        // Opening a file reports failures as errno; the message is only built when printed.
+        auto result = createInputStream(input.mName, options);
+        if (!result.mStream)
+        {
+            opened.mHealthStatus = ccwc::argument_parser::HealthStatus(result.mErrno);
+        }
+        else if (cache != nullptr)
+        {
+            // The path may have been replaced since the lookup: the result is stored under the
+            // key of the file that is actually read.
+            opened.mCacheKey = ResultCache::keyOf(result.mStatus, options.mDecompress);
+        }
+        opened.mStream = std::move(result.mStream);
+        return opened;
+    }
+
+    InputPrefetcher::InputPrefetcher(ccwc::argument_parser::InputSource& inputs,
+                                     InputStreamOptions options, const ResultCache* cache,
+                                     std::size_t maxOpen)
+        : m_inputs(inputs), m_options(options), m_cache(cache),
+          m_maxOpen(maxOpen == 0 ? detail::defaultMaxOpen() : maxOpen)
+    {
+        // A single input is opened on demand; a thread would only add latency.
+        if (!m_inputs.hasSingleInput())
+        {
+            m_opener = std::jthread([this] { run(); });
+        }
+    }
+
+    InputPrefetcher::~InputPrefetcher()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopped = true;
+        }
+        m_readyChanged.notify_all();
+    }
+
+    auto InputPrefetcher::openNext() -> std::optional<OpenedInput>
+    {
+        auto input = m_inputs.next();
+        if (!input.has_value())
+        {
+            return std::nullopt;
+        }
+        OpenedInput opened = openInput(input.value(), m_options, m_cache);
+        opened.mInput      = std::move(input.value());
+        return opened;
+    }
+
+    auto InputPrefetcher::run() -> void
+    {
+        nameTracedThread("prefetcher");
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                m_readyChanged.wait(lock,
+                                    [this] { return m_stopped || m_ready.size() < m_maxOpen; });
+                if (m_stopped)
+                {
+                    return;
+                }
+            }
+
+            std::optional<OpenedInput> opened;
+            std::exception_ptr         error;
+            try
+            {
+                opened = openNext();
+            }
+            catch (...)
+            {
+                // Rethrown on the counting thread once the inputs before it are counted.
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard lock(m_mutex);
+                if (!opened.has_value())
+                {
+                    m_exhausted = true;
+                    m_error     = error;
+                }
+                else
+                {
+                    m_ready.push_back(std::move(opened.value()));
+                }
+            }
+            m_readyChanged.notify_all();
+            if (!opened.has_value())
+            {
+                return;
+            }
+        }
+    }
+
+    auto InputPrefetcher::next() -> std::optional<OpenedInput>
+    {
+        if (!m_opener.joinable())
+        {
+            return openNext();
+        }
+
+        OpenedInput opened;
+        {
+            std::unique_lock lock(m_mutex);
+            m_readyChanged.wait(lock, [this] { return !m_ready.empty() || m_exhausted; });
+            if (m_ready.empty())
+            {
+                if (m_error)
+                {
+                    std::rethrow_exception(m_error);
+                }
+                return std::nullopt;
+            }
+            opened = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+        m_readyChanged.notify_all();
+        return opened;
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,136 @@
+#ifndef CCWC_ALGORITHM_INPUT_PREFETCHER_HPP
+#define CCWC_ALGORITHM_INPUT_PREFETCHER_HPP
+
+#include "argument_parser/input_objects.hpp"
+#include "argument_parser/input_source.hpp"
+#include "result_cache.hpp"
+#include "universal_input_stream.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief An input opened by the InputPrefetcher.
+     */
+    struct OpenedInput
+    {
+        /**
+         * @brief The input, as the InputSource handed it out.
+         */
+        ccwc::argument_parser::InputDataObject mInput;
+
+        /**
+         * @brief The opened stream, or nullptr if opening failed.
+         */
+        std::unique_ptr<UniversalInputStream> mStream;
+
+        /**
+         * @brief Why opening failed (healthy on success).
+         */
+        ccwc::argument_parser::HealthStatus mHealthStatus;
+
+        /**
+         * @brief The counter from the result cache; the input was not opened in that case.
+         */
+        std::optional<Counter> mCached;
+
+        /**
+         * @brief Cache key of the input, if its result is to be stored in the cache.
+         */
+        std::optional<CacheKey> mCacheKey;
+    };
+
+    /**
+     * @brief Opens inputs just in time, a bounded number ahead of the counting stage.
+     *
+     * A background thread takes the inputs from the InputSource and opens them in order (stat,
+     * open, mmap) while the previous ones are being counted, so the latency of opening overlaps
+     * with counting. At most `maxOpen` opened inputs wait in the queue, which bounds the number
+     * of descriptors and mappings held at once, and of names read ahead from a file list, no
+     * matter how many inputs there are. Inputs that are already unhealthy are not opened at
+     * all.
+     */
+    class InputPrefetcher
+    {
+      private:
+        ccwc::argument_parser::InputSource& m_inputs;
+        InputStreamOptions                  m_options;
+        const ResultCache*                  m_cache;
+        std::size_t                         m_maxOpen;
+        std::deque<OpenedInput>             m_ready;
+        bool                                m_exhausted{false}; // the opener took the last input
+        std::exception_ptr                  m_error;            // why the source failed
+        bool                                m_stopped{false};
+        std::mutex                          m_mutex;
+        std::condition_variable             m_readyChanged;
+        std::jthread                        m_opener;
+
+        /**
+         * @brief Take the next input from the source and open it.
+         */
+        auto openNext() -> std::optional<OpenedInput>;
+
+        /**
+         * @brief Body of the opener thread.
+         */
+        auto run() -> void;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param inputs The inputs to open, in counting order; must outlive the prefetcher,
+         * which is the only one to take inputs from it.
+         * @param options Options used to open the inputs.
+         * @param cache If set, inputs found in the cache are answered without opening them.
+         * @param maxOpen Maximum number of opened inputs waiting to be counted; 0 picks a
+         * default from the descriptor limit.
+         */
+        InputPrefetcher(ccwc::argument_parser::InputSource& inputs, InputStreamOptions options,
+                        const ResultCache* cache = nullptr, std::size_t maxOpen = 0);
+
+        /**
+         * @brief Destructor: stops the opener thread.
+         */
+        ~InputPrefetcher();
+
+        InputPrefetcher(const InputPrefetcher&)                    = delete;
+        auto operator=(const InputPrefetcher&) -> InputPrefetcher& = delete;
+        InputPrefetcher(InputPrefetcher&&)                         = delete;
+        auto operator=(InputPrefetcher&&) -> InputPrefetcher&      = delete;
+
+        /**
+         * @brief Take the next input, in the order of the source.
+         *
+         * Blocks until the opener thread opened it.
+         * @return The input, or std::nullopt once every input was taken.
+         * @throws ccwc::exception::FileOperationException If the file list cannot be read.
+         */
+        auto next() -> std::optional<OpenedInput>;
+    };
+
+    /**
+     * @brief Open a single input described by an input data object.
+     *
+     * With a cache, regular files are first looked up by their stat() identity; a hit returns
+     * the cached counter without opening the file.
+     *
+     * @return The opened input; on failure the stream is nullptr and the error is set.
+     */
+    auto openInput(const ccwc::argument_parser::InputDataObject& input,
+                   const InputStreamOptions& options, const ResultCache* cache = nullptr)
+        -> OpenedInput;
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_INPUT_PREFETCHER_HPP
@@ -0,0 +1,107 @@
+#include "interval_counter.hpp"
+
+#include "counter_state_machine.hpp"
+#include "exception/exception.hpp"
+#include "incremental_counter.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    auto CountSnapshot::publish(const Counter& counter) -> void
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_counter = counter;
+    }
+
+    auto CountSnapshot::finish() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished = true;
+        }
+        m_finished_changed.notify_all();
+    }
+
+    auto CountSnapshot::waitUntil(std::chrono::steady_clock::time_point deadline) -> bool
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_finished_changed.wait_until(lock, deadline, [this] { return m_finished; });
+    }
+
+    auto CountSnapshot::latest() const -> Counter
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_counter;
+    }
+
+    auto countWithIntervals(int fd, const std::string& name, std::chrono::milliseconds interval,
+                            const std::function<void(const Counter&, const Counter&)>& report)
+        -> Counter
+    {
+        CountSnapshot      snapshot;
+        std::exception_ptr failure;
+
+        std::thread counting([&] {
+            try
+            {
+                auto readNext = [fd](unsigned char* data, std::size_t size, std::uint64_t) {
+                    return ::read(fd, data, size);
+                };
+
+                auto                       stateMachine = buildCounterStateMachineChain();
+                AppendCount                count;
+                std::vector<unsigned char> buffer;
+                while (true)
+                {
+                    ssize_t bytesRead = countChunk(readNext, count, *stateMachine, buffer);
+                    if (bytesRead < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if (bytesRead < 0)
+                    {
+                        throw ccwc::exception::FileOperationException(name + ": " +
+                                                                      std::strerror(errno));
+                    }
+                    snapshot.publish(count.total(*stateMachine));
+                    if (bytesRead == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+            snapshot.finish();
+        });
+
+        Counter reported;
+        auto    deadline = std::chrono::steady_clock::now() + interval;
+        while (!snapshot.waitUntil(deadline))
+        {
+            Counter total = snapshot.latest();
+            Counter delta = total;
+            delta -= reported;
+            report(delta, total);
+            reported = total;
+            deadline += interval;
+        }
+        counting.join();
+
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+        return snapshot.latest();
+    }
+
+} // namespace ccwc::algorithm
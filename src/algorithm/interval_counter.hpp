@@ -0,0 +1,75 @@
+#ifndef CCWC_ALGORITHM_INTERVAL_COUNTER_HPP
+#define CCWC_ALGORITHM_INTERVAL_COUNTER_HPP
+
+#include "counter.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief The latest counts of an input that is still being counted.
+     *
+     * The counting thread publishes a copy of its counter after every chunk it reads; another
+     * thread takes the latest one whenever it wants to report. Publishing only copies a Counter
+     * under a mutex that is never held for longer, so it does not slow the counting down.
+     */
+    class CountSnapshot
+    {
+      private:
+        mutable std::mutex      m_mutex;
+        std::condition_variable m_finished_changed;
+        Counter                 m_counter;
+        bool                    m_finished{false};
+
+      public:
+        /**
+         * @brief Replace the latest counts.
+         */
+        auto publish(const Counter& counter) -> void;
+
+        /**
+         * @brief Mark the input as completely counted.
+         */
+        auto finish() -> void;
+
+        /**
+         * @brief Wait until the input is completely counted or `deadline` passed.
+         * @return Whether the input is completely counted.
+         */
+        auto waitUntil(std::chrono::steady_clock::time_point deadline) -> bool;
+
+        /**
+         * @brief The latest counts.
+         */
+        [[nodiscard]] auto latest() const -> Counter;
+    };
+
+    /**
+     * @brief Count an input that may never end, reporting rolling counts every interval.
+     *
+     * The input is read in chunks on a separate thread, which publishes its counts to a
+     * CountSnapshot after each chunk, so a report also covers a line that arrived just before
+     * the input went quiet. This thread wakes up once per interval and calls `report` with what
+     * was counted since the previous report and in total. The reports are formatted and printed
+     * here, never on the counting thread.
+     *
+     * @param fd The descriptor to read, e.g. the standard input.
+     * @param name Name of the input, for error messages.
+     * @param interval Time between two reports.
+     * @param report Called with the delta since the previous report and the totals.
+     * @return The counter of the whole input.
+     * @throws ccwc::exception::FileOperationException if the input cannot be read.
+     */
+    auto countWithIntervals(int fd, const std::string& name, std::chrono::milliseconds interval,
+                            const std::function<void(const Counter&, const Counter&)>& report)
+        -> Counter;
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_INTERVAL_COUNTER_HPP
@@ -0,0 +1,515 @@
+#include "parallel_frame_counter.hpp"
+
+#include "counter_state_machine.hpp"
+#include "exception/exception.hpp"
+#include "file_descriptor.hpp"
+#include "segment_counter.hpp"
+#include "trace.hpp"
+#include "universal_input_stream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <thread>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr std::uint32_t ZSTD_FRAME_MAGIC          = 0xFD2FB528U;
+        constexpr std::uint32_t ZSTD_SKIPPABLE_MAGIC      = 0x184D2A50U;
+        constexpr std::uint32_t ZSTD_SKIPPABLE_MAGIC_MASK = 0xFFFFFFF0U;
+        constexpr std::size_t   ZSTD_BLOCK_HEADER_SIZE    = 3;
+        constexpr std::size_t   ZSTD_CHECKSUM_SIZE        = 4;
+        constexpr unsigned      ZSTD_BLOCK_TYPE_RLE       = 1;
+        constexpr unsigned      ZSTD_BLOCK_TYPE_RESERVED  = 3;
+
+        constexpr std::size_t   GZIP_FIXED_HEADER_SIZE = 12; // up to and including XLEN
+        constexpr unsigned char GZIP_FLAG_EXTRA        = 0x04;
+        constexpr unsigned char GZIP_DEFLATE           = 0x08;
+        constexpr unsigned char BGZF_SI1               = 'B';
+        constexpr unsigned char BGZF_SI2               = 'C';
+        constexpr std::size_t   BGZF_SLEN              = 2;
+
+        constexpr unsigned BYTE_BITS = 8;
+
+        /**
+         * @brief Read a little-endian unsigned integer of `width` bytes.
+         */
+        auto readLittleEndian(std::span<const unsigned char> data, std::size_t offset,
+                              std::size_t width) -> std::uint64_t
+        {
+            std::uint64_t value{0};
+            for (std::size_t i = 0; i < width; ++i)
+            {
+                value |= static_cast<std::uint64_t>(data[offset + i]) << (BYTE_BITS * i);
+            }
+            return value;
+        }
+
+        /**
+         * @brief Size of the zstd frame starting at `offset`, or 0 if it is malformed.
+         */
+        auto zstdFrameSize(std::span<const unsigned char> data, std::size_t offset)
+            -> std::size_t
+        {
+            constexpr std::size_t                MAGIC_SIZE = 4;
+            constexpr std::array<std::size_t, 4> DICT_ID_SIZES{0, 1, 2, 4};
+            constexpr std::array<std::size_t, 4> CONTENT_SIZE_SIZES{0, 2, 4, 8};
+
+            std::size_t pos = offset + MAGIC_SIZE;
+            if (pos >= data.size())
+            {
+                return 0;
+            }
+
+            unsigned char descriptor    = data[pos++];
+            unsigned      sizeFlag      = descriptor >> 6U;
+            bool          singleSegment = ((descriptor >> 5U) & 1U) != 0;
+            bool          hasChecksum   = ((descriptor >> 2U) & 1U) != 0;
+            unsigned      dictIdFlag    = descriptor & 3U;
+
+            pos += singleSegment ? 0 : 1;
+            pos += DICT_ID_SIZES.at(dictIdFlag);
+            pos += (sizeFlag == 0 && singleSegment) ? 1 : CONTENT_SIZE_SIZES.at(sizeFlag);
+
+            bool lastBlock{false};
+            while (!lastBlock)
+            {
+                if (pos + ZSTD_BLOCK_HEADER_SIZE > data.size())
+                {
+                    return 0;
+                }
+                auto header =
+                    static_cast<std::uint32_t>(readLittleEndian(data, pos, ZSTD_BLOCK_HEADER_SIZE));
+                unsigned    type      = (header >> 1U) & 3U;
+                std::size_t blockSize = header >> 3U;
+                lastBlock             = (header & 1U) != 0;
+                if (type == ZSTD_BLOCK_TYPE_RESERVED)
+                {
+                    return 0;
+                }
+                pos += ZSTD_BLOCK_HEADER_SIZE + (type == ZSTD_BLOCK_TYPE_RLE ? 1 : blockSize);
+            }
+            pos += hasChecksum ? ZSTD_CHECKSUM_SIZE : 0;
+
+            return pos <= data.size() ? pos - offset : 0;
+        }
+
+        auto findZstdFrames(std::span<const unsigned char> data)
+            -> std::optional<std::vector<CompressedFrame>>
+        {
+            constexpr std::size_t MAGIC_SIZE = 4;
+
+            std::vector<CompressedFrame> frames;
+            std::size_t                  offset{0};
+            while (offset < data.size())
+            {
+                if (offset + MAGIC_SIZE > data.size())
+                {
+                    return std::nullopt;
+                }
+                auto magic = static_cast<std::uint32_t>(readLittleEndian(data, offset, MAGIC_SIZE));
+                if ((magic & ZSTD_SKIPPABLE_MAGIC_MASK) == ZSTD_SKIPPABLE_MAGIC)
+                {
+                    if (offset + 2 * MAGIC_SIZE > data.size())
+                    {
+                        return std::nullopt;
+                    }
+                    offset += 2 * MAGIC_SIZE + readLittleEndian(data, offset + MAGIC_SIZE,
+                                                                MAGIC_SIZE);
+                    continue;
+                }
+                if (magic != ZSTD_FRAME_MAGIC)
+                {
+                    return std::nullopt;
+                }
+
+                std::size_t size = zstdFrameSize(data, offset);
+                if (size == 0)
+                {
+                    return std::nullopt;
+                }
+                frames.push_back({offset, size});
+                offset += size;
+            }
+            return frames;
+        }
+
+        /**
+         * @brief Size of the BGZF block starting at `offset`, or 0 if it is not a BGZF block.
+         */
+        auto bgzfBlockSize(std::span<const unsigned char> data, std::size_t offset)
+            -> std::size_t
+        {
+            constexpr std::size_t XLEN_OFFSET     = 10;
+            constexpr std::size_t SUBFIELD_HEADER = 4;
+            constexpr std::size_t FLAGS_OFFSET    = 3;
+            constexpr std::size_t METHOD_OFFSET   = 2;
+            constexpr std::size_t TWO_BYTES       = 2;
+
+            if (offset + GZIP_FIXED_HEADER_SIZE > data.size() || data[offset] != 0x1F ||
+                data[offset + 1] != 0x8B || data[offset + METHOD_OFFSET] != GZIP_DEFLATE ||
+                (data[offset + FLAGS_OFFSET] & GZIP_FLAG_EXTRA) == 0)
+            {
+                return 0;
+            }
+
+            std::size_t extraLength = readLittleEndian(data, offset + XLEN_OFFSET, TWO_BYTES);
+            std::size_t pos         = offset + GZIP_FIXED_HEADER_SIZE;
+            std::size_t extraEnd    = pos + extraLength;
+            if (extraEnd > data.size())
+            {
+                return 0;
+            }
+
+            while (pos + SUBFIELD_HEADER <= extraEnd)
+            {
+                std::size_t fieldLength = readLittleEndian(data, pos + 2, TWO_BYTES);
+                if (data[pos] == BGZF_SI1 && data[pos + 1] == BGZF_SI2 &&
+                    fieldLength == BGZF_SLEN && pos + SUBFIELD_HEADER + BGZF_SLEN <= extraEnd)
+                {
+                    std::size_t blockSize =
+                        readLittleEndian(data, pos + SUBFIELD_HEADER, TWO_BYTES) + 1;
+                    return offset + blockSize <= data.size() ? blockSize : 0;
+                }
+                pos += SUBFIELD_HEADER + fieldLength;
+            }
+            return 0;
+        }
+
+        auto findBgzfBlocks(std::span<const unsigned char> data)
+            -> std::optional<std::vector<CompressedFrame>>
+        {
+            std::vector<CompressedFrame> frames;
+            std::size_t                  offset{0};
+            while (offset < data.size())
+            {
+                std::size_t size = bgzfBlockSize(data, offset);
+                if (size == 0)
+                {
+                    return std::nullopt;
+                }
+                frames.push_back({offset, size});
+                offset += size;
+            }
+            return frames;
+        }
+
+        /**
+         * @brief Bytes a frame is inflated by at a time, plus room for a character carried over
+         * from the previous chunk.
+         */
+        constexpr std::size_t DECODE_CHUNK_SIZE = static_cast<std::size_t>(256 * 1024);
+        constexpr std::size_t MAX_UTF8_SEQUENCE = 4;
+
+        /**
+         * @brief Set up `input` to inflate a single frame.
+         */
+        auto openFrame(std::span<const unsigned char> frame, CompressionFormat format,
+                       boost::iostreams::filtering_istreambuf& input) -> void
+        {
+            if (format == CompressionFormat::GZIP)
+            {
+                input.push(boost::iostreams::gzip_decompressor());
+            }
+            else
+            {
+                input.push(boost::iostreams::zstd_decompressor());
+            }
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            input.push(boost::iostreams::array_source(reinterpret_cast<const char*>(frame.data()),
+                                                      frame.size()));
+        }
+
+        /**
+         * @brief Result of counting one frame on a worker.
+         */
+        struct FrameResult
+        {
+            SegmentCount               mCore;  // Counts without the bytes below.
+            std::vector<unsigned char> mHead;  // Continuation bytes of the previous character.
+            std::vector<unsigned char> mTail;  // Incomplete character continued in the next frame.
+            std::string                mError; // Non-empty if the frame failed to decode.
+        };
+
+        /**
+         * @brief Decodes and counts the frames of a memory-mapped compressed file in parallel.
+         */
+        class ParallelFramedInputStream : public UniversalInputStream
+        {
+          private:
+            std::string                           m_name;
+            boost::iostreams::mapped_file_source  m_map;
+            std::vector<CompressedFrame>          m_frames;
+            CompressionFormat                     m_format;
+            std::unique_ptr<UniversalInputStream> m_streaming; // Fallback for nextByte().
+
+            [[nodiscard]] auto data() const -> std::span<const unsigned char>
+            {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                return {reinterpret_cast<const unsigned char*>(m_map.data()), m_map.size()};
+            }
+
+            /**
+             * @brief Inflate and count a frame a chunk at a time, so a worker holds one chunk
+             * whatever the size of the frame.
+             */
+            auto countFrame(std::size_t index, CounterStateMachine& stateMachine,
+                            std::vector<unsigned char>& buffer) const -> FrameResult
+            {
+                FrameResult result;
+                TraceSpan   span("count", m_name);
+                buffer.resize(DECODE_CHUNK_SIZE + MAX_UTF8_SEQUENCE);
+                std::size_t carried{0};
+                try
+                {
+                    const auto&                            frame = m_frames[index];
+                    boost::iostreams::filtering_istreambuf input;
+                    openFrame(data().subspan(frame.mOffset, frame.mSize), m_format, input);
+
+                    bool first{true};
+                    while (true)
+                    {
+                        auto* target = reinterpret_cast<char*>(buffer.data() + carried); // NOLINT
+                        auto  got =
+                            input.sgetn(target, static_cast<std::streamsize>(DECODE_CHUNK_SIZE));
+                        if (got <= 0)
+                        {
+                            break;
+                        }
+
+                        std::span<const unsigned char> bytes{
+                            buffer.data(), carried + static_cast<std::size_t>(got)};
+                        if (first && index > 0)
+                        {
+                            auto lead = leadingUtf8Continuation(bytes);
+                            result.mHead.assign(bytes.begin(),
+                                                bytes.begin() + static_cast<long>(lead));
+                            bytes = bytes.subspan(lead);
+                        }
+                        first = false;
+
+                        // A character split by the chunk border is completed by the next chunk.
+                        std::size_t keep = trailingIncompleteUtf8(bytes);
+                        result.mCore.append(
+                            countSegment(bytes.first(bytes.size() - keep), stateMachine));
+                        std::copy(bytes.end() - static_cast<long>(keep), bytes.end(),
+                                  buffer.begin());
+                        carried = keep;
+                        span.setBytes(result.mCore.mCounter.bytes + carried);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    result.mError = e.what();
+                    return result;
+                }
+
+                std::span<const unsigned char> rest{buffer.data(), carried};
+                if (index + 1 < m_frames.size())
+                {
+                    result.mTail.assign(rest.begin(), rest.end());
+                }
+                else
+                {
+                    result.mCore.append(countSegment(rest, stateMachine));
+                }
+                return result;
+            }
+
+          public:
+            ParallelFramedInputStream(std::string name, boost::iostreams::mapped_file_source map,
+                                      std::vector<CompressedFrame> frames,
+                                      CompressionFormat            format)
+                : m_name(std::move(name)), m_map(std::move(map)), m_frames(std::move(frames)),
+                  m_format(format)
+            {
+            }
+
+            ~ParallelFramedInputStream() override = default;
+
+            ParallelFramedInputStream(const ParallelFramedInputStream&) = delete;
+            auto operator=(const ParallelFramedInputStream&)
+                -> ParallelFramedInputStream&                      = delete;
+            ParallelFramedInputStream(ParallelFramedInputStream&&) = delete;
+            auto operator=(ParallelFramedInputStream&&) -> ParallelFramedInputStream& = delete;
+
+            [[nodiscard]] auto name() const -> std::string override
+            {
+                return m_name;
+            }
+
+            [[nodiscard]] auto isStdin() const -> bool override
+            {
+                return false;
+            }
+
+            /**
+             * @brief Byte-wise access goes through the streaming decoder.
+             */
+            auto nextByte() -> std::optional<unsigned char> override
+            {
+                if (!m_streaming)
+                {
+                    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+                    FileDescriptor fd{::open(m_name.c_str(), O_RDONLY | O_CLOEXEC)};
+                    if (!fd.valid())
+                    {
+                        throw ccwc::exception::FileOperationException(m_name + ": " +
+                                                                      std::strerror(errno));
+                    }
+                    m_streaming =
+                        createDecompressingInputStream(m_name, std::move(fd), false, m_format);
+                }
+                return m_streaming->nextByte();
+            }
+
+            auto reset() -> bool override
+            {
+                m_streaming.reset();
+                return true;
+            }
+
+            [[nodiscard]] auto good() const -> bool override
+            {
+                return m_map.is_open() && (!m_streaming || m_streaming->good());
+            }
+
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "mmap";
+            }
+
+            [[nodiscard]] auto kernel() const -> std::string_view override
+            {
+                return "parallel frames";
+            }
+
+            [[nodiscard]] auto countsOffThread() const -> bool override
+            {
+                return true;
+            }
+
+            /**
+             * @brief The whole file is one mapped window.
+             */
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return 1;
+            }
+
+            /**
+             * @brief Decode and count every frame on a pool of workers and merge the results.
+             */
+            auto countAll() -> std::optional<Counter> override
+            {
+                std::vector<FrameResult> results(m_frames.size());
+                std::atomic<std::size_t> nextFrame{0};
+
+                auto worker = [&]
+                {
+                    nameTracedThread("frame worker");
+                    auto                       stateMachine = buildCounterStateMachineChain();
+                    std::vector<unsigned char> buffer;
+                    for (std::size_t index = nextFrame.fetch_add(1); index < m_frames.size();
+                         index             = nextFrame.fetch_add(1))
+                    {
+                        results[index] = countFrame(index, *stateMachine, buffer);
+                    }
+                };
+
+                std::size_t workerCount = std::clamp<std::size_t>(
+                    std::thread::hardware_concurrency(), 1, m_frames.size());
+                {
+                    std::vector<std::jthread> workers;
+                    workers.reserve(workerCount);
+                    for (std::size_t i = 0; i < workerCount; ++i)
+                    {
+                        workers.emplace_back(worker);
+                    }
+                }
+
+                TraceSpan                  span("merge", m_name);
+                auto                       stateMachine = buildCounterStateMachineChain();
+                SegmentCount               total;
+                std::vector<unsigned char> border;
+                for (const auto& result : results)
+                {
+                    if (!result.mError.empty())
+                    {
+                        throw ccwc::exception::FileOperationException(m_name + ": " +
+                                                                      result.mError);
+                    }
+                    // Stitch the character split by the previous border back together.
+                    border.insert(border.end(), result.mHead.begin(), result.mHead.end());
+                    total.append(countSegment(border, *stateMachine));
+                    total.append(result.mCore);
+                    border = result.mTail;
+                }
+                total.append(countSegment(border, *stateMachine));
+                span.setBytes(total.mCounter.bytes);
+
+                return total.mCounter;
+            }
+        };
+    } // namespace detail
+
+    auto findCompressedFrames(std::span<const unsigned char> data, CompressionFormat format)
+        -> std::optional<std::vector<CompressedFrame>>
+    {
+        switch (format)
+        {
+        case CompressionFormat::ZSTD:
+            return detail::findZstdFrames(data);
+        case CompressionFormat::GZIP:
+            return detail::findBgzfBlocks(data);
+        default:
+            return std::nullopt;
+        }
+    }
+
+    auto createParallelFramedInputStream(const std::string& filename, CompressionFormat format)
+        -> std::unique_ptr<UniversalInputStream>
+    {
+        boost::iostreams::mapped_file_source map;
+        try
+        {
+            TraceSpan span("map", filename);
+            map.open(filename);
+            span.setBytes(map.is_open() ? map.size() : 0);
+        }
+        catch (const std::exception&)
+        {
+            return nullptr;
+        }
+        if (!map.is_open())
+        {
+            return nullptr;
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        std::span<const unsigned char> data{reinterpret_cast<const unsigned char*>(map.data()),
+                                            map.size()};
+        auto frames = findCompressedFrames(data, format);
+        if (!frames.has_value() || frames->size() < 2)
+        {
+            return nullptr;
+        }
+
+        return std::make_unique<detail::ParallelFramedInputStream>(filename, std::move(map),
+                                                                   std::move(frames.value()),
+                                                                   format);
+    }
+
+} // namespace ccwc::algorithm
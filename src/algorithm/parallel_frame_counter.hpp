@@ -0,0 +1,58 @@
+#ifndef CCWC_ALGORITHM_PARALLEL_FRAME_COUNTER_HPP
+#define CCWC_ALGORITHM_PARALLEL_FRAME_COUNTER_HPP
+
+#include "compressed_input_stream.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    class UniversalInputStream;
+
+    /**
+     * @brief Location of an independently decodable frame inside a compressed file.
+     */
+    struct CompressedFrame
+    {
+        std::size_t mOffset{0};
+        std::size_t mSize{0};
+    };
+
+    /**
+     * @brief Split a compressed file into independently decodable frames.
+     *
+     * Zstandard frames are found by walking the frame and block headers; gzip files are split
+     * only if every member is a BGZF block (its size is stored in the header). Plain multi-member
+     * gzip files cannot be split without inflating them and are reported as not splittable.
+     *
+     * @param data The whole compressed file.
+     * @param format GZIP or ZSTD.
+     * @return The frames in file order, or std::nullopt if the file cannot be split.
+     */
+    auto findCompressedFrames(std::span<const unsigned char> data, CompressionFormat format)
+        -> std::optional<std::vector<CompressedFrame>>;
+
+    /**
+     * @brief Creates a stream that decompresses and counts the frames of a file in parallel.
+     *
+     * Each worker inflates and counts whole frames on its own, through a fixed-size chunk; the
+     * partial counts are merged in file order, correcting words and UTF-8 characters that
+     * straddle a frame border.
+     *
+     * @param filename The compressed file.
+     * @param format GZIP or ZSTD.
+     * @return The stream, or nullptr if the file is a single frame or cannot be split, in which
+     * case the streaming decoder should be used.
+     */
+    auto createParallelFramedInputStream(const std::string& filename, CompressionFormat format)
+        -> std::unique_ptr<UniversalInputStream>;
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_PARALLEL_FRAME_COUNTER_HPP
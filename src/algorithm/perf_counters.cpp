@@ -0,0 +1,303 @@
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr double NANOSECONDS_PER_MILLISECOND = 1e6;
+        constexpr int    NAME_WIDTH                  = 32;
+        constexpr int    NUMBER_WIDTH                = 14;
+        constexpr int    RATIO_WIDTH                 = 10;
+
+        /**
+         * @brief The header of a group read: the number of counters, then the times the group
+         * was enabled and actually running on the PMU.
+         */
+        constexpr std::size_t READ_HEADER = 3;
+
+        auto ratio(std::uint64_t numerator, std::uint64_t denominator) -> double
+        {
+            return denominator > 0
+                       ? static_cast<double>(numerator) / static_cast<double>(denominator)
+                       : 0;
+        }
+
+        /**
+         * @brief Print a count, or "n/a" if the counter was not opened.
+         */
+        auto appendCount(std::ostringstream& line, bool available, std::uint64_t value, int width)
+            -> void
+        {
+            if (available)
+            {
+                line << std::setw(width) << value;
+                return;
+            }
+            line << std::setw(width) << "n/a";
+        }
+
+        auto appendRatio(std::ostringstream& line, bool available, double value) -> void
+        {
+            if (available)
+            {
+                line << std::setw(RATIO_WIDTH) << value;
+                return;
+            }
+            line << std::setw(RATIO_WIDTH) << "n/a";
+        }
+
+        auto appendUnavailable(std::ostringstream& lines, std::string_view what, int error)
+            -> void
+        {
+            if (error == 0)
+            {
+                return;
+            }
+            lines << "ccwc: perf: " << what << " unavailable: " << std::strerror(error);
+            if (error == EACCES || error == EPERM)
+            {
+                lines << " (see /proc/sys/kernel/perf_event_paranoid)";
+            }
+            lines << '\n';
+        }
+    } // namespace detail
+
+    auto PerfSample::operator-=(const PerfSample& other) -> PerfSample&
+    {
+        mTaskClock -= other.mTaskClock;
+        mCycles -= other.mCycles;
+        mInstructions -= other.mInstructions;
+        mCacheMisses -= other.mCacheMisses;
+        mBranchMisses -= other.mBranchMisses;
+        mKernelCycles -= other.mKernelCycles;
+        mKernelInstructions -= other.mKernelInstructions;
+        return *this;
+    }
+
+    auto PerfSample::operator+=(const PerfSample& other) -> PerfSample&
+    {
+        mTaskClock += other.mTaskClock;
+        mCycles += other.mCycles;
+        mInstructions += other.mInstructions;
+        mCacheMisses += other.mCacheMisses;
+        mBranchMisses += other.mBranchMisses;
+        mKernelCycles += other.mKernelCycles;
+        mKernelInstructions += other.mKernelInstructions;
+        return *this;
+    }
+
+    PerfCounters::PerfCounters()
+    {
+#if defined(__linux__)
+        if (open(m_user, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false,
+                 &PerfSample::mCycles))
+        {
+            open(m_user, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false,
+                 &PerfSample::mInstructions);
+            open(m_user, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, false,
+                 &PerfSample::mCacheMisses);
+            open(m_user, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, false,
+                 &PerfSample::mBranchMisses);
+        }
+        if (open(m_kernel, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true,
+                 &PerfSample::mKernelCycles))
+        {
+            open(m_kernel, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true,
+                 &PerfSample::mKernelInstructions);
+        }
+        open(m_clock, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, false,
+             &PerfSample::mTaskClock);
+#else
+        m_user.mErrno   = ENOSYS;
+        m_kernel.mErrno = ENOSYS;
+        m_clock.mErrno  = ENOSYS;
+#endif
+    }
+
+    auto PerfCounters::open(Group& group, std::uint32_t type, std::uint64_t config, bool kernel,
+                            std::uint64_t PerfSample::*field) -> bool
+    {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.exclude_hv     = 1;
+        attr.exclude_kernel = kernel ? 0 : 1;
+        attr.exclude_user   = kernel ? 1 : 0;
+        attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        if (type == PERF_TYPE_SOFTWARE)
+        {
+            // The task clock counts the time on the CPU whatever the mode.
+            attr.exclude_kernel = 0;
+            attr.exclude_user   = 0;
+        }
+
+        int  leader = group.mCounters.empty() ? -1 : group.mCounters.front().get();
+        auto fd     = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0)
+        {
+            group.mErrno = errno;
+            return false;
+        }
+        group.mCounters.emplace_back(fd);
+        group.mFields.push_back(field);
+        return true;
+#else
+        (void)type;
+        (void)config;
+        (void)kernel;
+        (void)field;
+        group.mErrno = ENOSYS;
+        return false;
+#endif
+    }
+
+    auto PerfCounters::read(const Group& group, PerfSample& sample) -> void
+    {
+        if (group.mCounters.empty())
+        {
+            return;
+        }
+
+        std::vector<std::uint64_t> values(detail::READ_HEADER + group.mFields.size());
+        std::size_t                size = values.size() * sizeof(std::uint64_t);
+        if (::read(group.mCounters.front().get(), values.data(), size) !=
+            static_cast<ssize_t>(size))
+        {
+            return;
+        }
+
+        // A group that shared the PMU with other events only ran part of the time; its counts
+        // are scaled up to the time it was enabled.
+        std::uint64_t enabled = values[1];
+        std::uint64_t running = values[2];
+        std::size_t   count   = std::min<std::size_t>(values[0], group.mFields.size());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint64_t value = values[detail::READ_HEADER + i];
+            if (running > 0 && running < enabled)
+            {
+                value = static_cast<std::uint64_t>(static_cast<double>(value) *
+                                                   detail::ratio(enabled, running));
+            }
+            sample.*group.mFields[i] = value;
+        }
+    }
+
+    auto PerfCounters::sample() const -> PerfSample
+    {
+        PerfSample result;
+        read(m_clock, result);
+        read(m_user, result);
+        read(m_kernel, result);
+        return result;
+    }
+
+    auto PerfCounters::book(const std::string& stage, StageMode mode, const PerfSample& delta,
+                            std::uint64_t bytes) -> void
+    {
+        auto [found, inserted] = m_stages.try_emplace(stage);
+        if (inserted)
+        {
+            found->second.mMode = mode;
+            m_order.push_back(stage);
+        }
+        found->second.mSample += delta;
+        found->second.mBytes += bytes;
+    }
+
+    auto PerfCounters::add(const std::string& stage, const PerfSample& before, std::uint64_t bytes)
+        -> void
+    {
+        PerfSample delta = sample();
+        delta -= before;
+        book(stage, StageMode::ALL, delta, bytes);
+    }
+
+    auto PerfCounters::addCount(const std::string& kernel, const PerfSample& before,
+                                std::uint64_t bytes) -> void
+    {
+        PerfSample delta = sample();
+        delta -= before;
+        book("read (" + kernel + ")", StageMode::KERNEL, delta, bytes);
+        book("count (" + kernel + ")", StageMode::USER, delta, bytes);
+    }
+
+    auto PerfCounters::addOffThread(const std::string& stage, std::uint64_t bytes) -> void
+    {
+        book(stage, StageMode::NONE, PerfSample{}, bytes);
+    }
+
+    auto PerfCounters::report() const -> std::string
+    {
+        bool user   = !m_user.mCounters.empty();
+        bool kernel = !m_kernel.mCounters.empty();
+        bool clock  = !m_clock.mCounters.empty();
+
+        std::ostringstream lines;
+        lines.precision(3);
+        lines << std::fixed << "ccwc: perf: " << std::left << std::setw(detail::NAME_WIDTH)
+              << "stage" << std::right << std::setw(detail::NUMBER_WIDTH) << "bytes"
+              << std::setw(detail::RATIO_WIDTH) << "CPU ms" << std::setw(detail::RATIO_WIDTH)
+              << "ns/byte" << std::setw(detail::NUMBER_WIDTH) << "cycles"
+              << std::setw(detail::NUMBER_WIDTH) << "instructions"
+              << std::setw(detail::RATIO_WIDTH) << "IPC" << std::setw(detail::RATIO_WIDTH)
+              << "cycles/B" << std::setw(detail::NUMBER_WIDTH) << "cache misses"
+              << std::setw(detail::NUMBER_WIDTH) << "branch misses" << '\n';
+
+        for (const std::string& name : m_order)
+        {
+            const StageTotal& stage = m_stages.at(name);
+            const PerfSample& s     = stage.mSample;
+
+            // The task clock does not tell the modes apart: the CPU time of reading and counting
+            // an input is shown once, on its count stage.
+            bool          measured     = stage.mMode != StageMode::NONE;
+            bool          timed        = clock && measured && stage.mMode != StageMode::KERNEL;
+            bool          inKernel     = stage.mMode == StageMode::KERNEL;
+            bool          cycled       = measured && (inKernel ? kernel : user);
+            bool          missed       = user && measured && !inKernel;
+            std::uint64_t cycles       = inKernel ? s.mKernelCycles : s.mCycles;
+            std::uint64_t instructions = inKernel ? s.mKernelInstructions : s.mInstructions;
+            if (stage.mMode == StageMode::ALL)
+            {
+                cycled = user && kernel;
+                cycles += s.mKernelCycles;
+                instructions += s.mKernelInstructions;
+            }
+
+            lines << "ccwc: perf: " << std::left << std::setw(detail::NAME_WIDTH) << name
+                  << std::right << std::setw(detail::NUMBER_WIDTH) << stage.mBytes;
+            detail::appendRatio(lines, timed,
+                                static_cast<double>(s.mTaskClock) /
+                                    detail::NANOSECONDS_PER_MILLISECOND);
+            detail::appendRatio(lines, timed, detail::ratio(s.mTaskClock, stage.mBytes));
+            detail::appendCount(lines, cycled, cycles, detail::NUMBER_WIDTH);
+            detail::appendCount(lines, cycled, instructions, detail::NUMBER_WIDTH);
+            detail::appendRatio(lines, cycled, detail::ratio(instructions, cycles));
+            detail::appendRatio(lines, cycled, detail::ratio(cycles, stage.mBytes));
+            detail::appendCount(lines, missed, s.mCacheMisses, detail::NUMBER_WIDTH);
+            detail::appendCount(lines, missed, s.mBranchMisses, detail::NUMBER_WIDTH);
+            lines << '\n';
+        }
+
+        detail::appendUnavailable(lines, "user mode hardware counters", m_user.mErrno);
+        detail::appendUnavailable(lines, "kernel mode hardware counters", m_kernel.mErrno);
+        detail::appendUnavailable(lines, "task clock", m_clock.mErrno);
+        return lines.str();
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,165 @@
+#ifndef CCWC_ALGORITHM_PERF_COUNTERS_HPP
+#define CCWC_ALGORITHM_PERF_COUNTERS_HPP
+
+#include "file_descriptor.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief The counters of the calling thread at one point; a counter that could not be opened
+     * stays 0.
+     */
+    struct PerfSample
+    {
+        /**
+         * @brief Nanoseconds on the CPU, user and kernel mode; a software counter.
+         */
+        std::uint64_t mTaskClock{0};
+
+        /**
+         * @brief Counted in user mode, where the bytes are counted and the report formatted.
+         */
+        std::uint64_t mCycles{0};
+        std::uint64_t mInstructions{0};
+        std::uint64_t mCacheMisses{0};
+        std::uint64_t mBranchMisses{0};
+
+        /**
+         * @brief Counted in kernel mode, where the input is read and its pages faulted in.
+         */
+        std::uint64_t mKernelCycles{0};
+        std::uint64_t mKernelInstructions{0};
+
+        /**
+         * @brief Operator to subtract an earlier sample.
+         */
+        auto operator-=(const PerfSample& other) -> PerfSample&;
+
+        /**
+         * @brief Operator to add the counts of another span.
+         */
+        auto operator+=(const PerfSample& other) -> PerfSample&;
+    };
+
+    /**
+     * @brief Hardware performance counters of the calling thread, read around the stages of the
+     * pipeline (`--perf-counters`).
+     *
+     * Cycles, instructions, cache misses and branch misses are counted in user mode, and cycles
+     * and instructions again in kernel mode. The reads are interleaved with the counting byte by
+     * byte, so the privilege level is what tells the read stage (kernel mode: read(), page
+     * faults) from the count stage (user mode) apart. Each set is one perf_event_open() group,
+     * scheduled on the PMU together and read with a single read().
+     *
+     * The counters only see the calling thread. Inputs decoded or counted on threads of their
+     * stream are booked with their bytes only.
+     *
+     * Counters that cannot be opened (no PMU in a virtual machine, kernel mode refused by
+     * perf_event_paranoid) are reported once and left out; the software task clock is always
+     * there, so every stage still gets its CPU time per byte.
+     */
+    class PerfCounters
+    {
+      private:
+        /**
+         * @brief Counters opened as one group, the leader first.
+         */
+        struct Group
+        {
+            std::vector<FileDescriptor>              mCounters;
+            std::vector<std::uint64_t PerfSample::*> mFields;
+            int                                      mErrno{0};
+        };
+
+        /**
+         * @brief Which counters of a sample a stage shows.
+         */
+        enum class StageMode : std::uint8_t
+        {
+            USER,   // The count stage.
+            KERNEL, // The read stage.
+            ALL,    // A stage run apart, e.g. formatting.
+            NONE,   // Run on other threads, which these counters do not see.
+        };
+
+        /**
+         * @brief What a stage accumulated.
+         */
+        struct StageTotal
+        {
+            StageMode     mMode{StageMode::ALL};
+            PerfSample    mSample;
+            std::uint64_t mBytes{0};
+        };
+
+        Group                             m_user;
+        Group                             m_kernel;
+        Group                             m_clock;
+        std::vector<std::string>          m_order;
+        std::map<std::string, StageTotal> m_stages;
+
+        /**
+         * @brief Add a counter to a group; the first one opened leads it.
+         * @return False if it could not be opened; its errno is kept in the group.
+         */
+        static auto open(Group& group, std::uint32_t type, std::uint64_t config, bool kernel,
+                         std::uint64_t PerfSample::*field) -> bool;
+
+        /**
+         * @brief Read the counters of a group into a sample.
+         */
+        static auto read(const Group& group, PerfSample& sample) -> void;
+
+        /**
+         * @brief Add a span to a stage, creating it the first time.
+         */
+        auto book(const std::string& stage, StageMode mode, const PerfSample& delta,
+                  std::uint64_t bytes) -> void;
+
+      public:
+        /**
+         * @brief Constructor: opens the counters for the calling thread, which must be the one
+         * the stages run on.
+         */
+        PerfCounters();
+
+        /**
+         * @brief The counters now.
+         */
+        [[nodiscard]] auto sample() const -> PerfSample;
+
+        /**
+         * @brief A stage ran since `before`.
+         * @param stage Its name, e.g. "format".
+         * @param bytes The input bytes it handled, the denominator of cycles per byte.
+         */
+        auto add(const std::string& stage, const PerfSample& before, std::uint64_t bytes) -> void;
+
+        /**
+         * @brief An input was counted since `before` by a counting kernel: its kernel mode part
+         * is booked as the read stage and its user mode part as the count stage of the kernel.
+         */
+        auto addCount(const std::string& kernel, const PerfSample& before, std::uint64_t bytes)
+            -> void;
+
+        /**
+         * @brief An input was counted by a kernel that runs on threads of its stream; its
+         * stage only gets the bytes, its counters are shown as n/a.
+         */
+        auto addOffThread(const std::string& stage, std::uint64_t bytes) -> void;
+
+        /**
+         * @brief A table of the stages: cycles, instructions, IPC, cycles per byte and misses.
+         */
+        [[nodiscard]] auto report() const -> std::string;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_PERF_COUNTERS_HPP
@@ -2,53 +2,429 @@
 #define CCWC_ALGORITHM_PROCESSOR_HPP
 
 #include "argument_parser/input_objects.hpp"
+#include "argument_parser/input_source.hpp"
 #include "counter.hpp"
+#include "counter_groups.hpp"
 #include "counter_state_machine.hpp"
+#include "directory_walker.hpp"
+#include "exception/exception.hpp"
+#include "input_prefetcher.hpp"
+#include "progress.hpp"
+#include "result_cache.hpp"
+#include "result_store.hpp"
+#include "statistics.hpp"
+#include "tar_archive.hpp"
+#include "trace.hpp"
+#include "universal_input_stream.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace ccwc::algorithm
 {
 
+    /**
+     * @brief Receives each input as soon as it is counted, with its position among the counted
+     * inputs (for a plain list, its index in the list).
+     */
+    using CountedCallback = std::function<void(
+        std::size_t, const ccwc::argument_parser::InputDataObject&, const Counter&)>;
+
+    /**
+     * @brief Count a single opened input stream.
+     * @param inputStream The stream to count.
+     * @param stateMachine The state machine chain to count with; it is reset afterwards.
+     * @param progress If set, the bytes counted are added to it as the count goes.
+     * @return The counter for the stream.
+     */
+    inline auto countStream(UniversalInputStream& inputStream, CounterStateMachine& stateMachine,
+                            ProgressTracker* progress = nullptr) -> Counter
+    {
+        TraceSpan span("count");
+        if (span.active())
+        {
+            span.setDetail(inputStream.name());
+        }
+        if (auto counted = inputStream.countAll())
+        {
+            if (progress != nullptr)
+            {
+                progress->addBytes(counted->bytes);
+            }
+            span.setBytes(counted->bytes);
+            return counted.value();
+        }
+
+        auto        counter = Counter();
+        std::size_t reported{0};
+        while (inputStream.good())
+        {
+            auto byte = inputStream.nextByte();
+            if (!byte.has_value())
+            {
+                break;
+            }
+            stateMachine.updateState(byte.value());
+            stateMachine.updateCounter(counter);
+            if (progress != nullptr && counter.bytes - reported >= PROGRESS_GRANULARITY)
+            {
+                progress->addBytes(counter.bytes - reported);
+                reported = counter.bytes;
+            }
+        }
+        // Finalize to handle any remaining buffered data
+        stateMachine.finalize(counter);
+        stateMachine.reset();
+        if (progress != nullptr)
+        {
+            progress->addBytes(counter.bytes - reported);
+        }
+        span.setBytes(counter.bytes);
+        return counter;
+    }
+
+    /**
+     * @brief Count an input opened by openInput, marking it unhealthy if it failed.
+     * @param opened The opened input.
+     * @param input The input data object the result belongs to.
+     * @param stateMachine The state machine chain to count with.
+     * @param cache If set, the result is stored in it when the input has a cache key.
+     * @param progress If set, the input is reported to it.
+     * @param stats If set, the input is measured for it unless it failed.
+     * @return The counter for the input (empty if it failed).
+     */
+    inline auto countOpened(OpenedInput& opened, ccwc::argument_parser::InputDataObject& input,
+                            CounterStateMachine& stateMachine, ResultCache* cache = nullptr,
+                            ProgressTracker*    progress = nullptr,
+                            StatisticsRecorder* stats    = nullptr) -> Counter
+    {
+        Counter counter;
+        if (progress != nullptr)
+        {
+            progress->startInput(input.mName);
+        }
+        const UniversalInputStream* stream = opened.mCached.has_value() ? nullptr
+                                                                        : opened.mStream.get();
+        InputMeasurement            measured;
+        if (stats != nullptr)
+        {
+            measured = stats->start(stream);
+        }
+
+        if (opened.mCached.has_value())
+        {
+            counter = opened.mCached.value();
+            if (progress != nullptr)
+            {
+                progress->addBytes(counter.bytes);
+            }
+        }
+        else if (!opened.mStream)
+        {
+            input.mHealthStatus = opened.mHealthStatus;
+        }
+        else
+        {
+            try
+            {
+                counter = countStream(*opened.mStream, stateMachine, progress);
+                if (cache != nullptr && opened.mCacheKey.has_value())
+                {
+                    cache->store(opened.mCacheKey.value(), counter);
+                }
+            }
+            catch (const ccwc::exception::FileOperationException& e)
+            {
+                stateMachine.reset();
+                input.mHealthStatus = ccwc::argument_parser::HealthStatus(false, e.what());
+            }
+        }
+
+        if (progress != nullptr)
+        {
+            progress->finishInput(counter);
+        }
+        if (stats != nullptr && input.mHealthStatus.mIsHealthy)
+        {
+            stats->finish(input.mName, measured, stream, counter);
+        }
+        return counter;
+    }
+
     /**
      * @brief Count the number of bytes, words, lines, and multibyte characters in the input data
      * objects.
-     * @param inputDataObjects The input data objects to count.
-     * @return The counters for each input data object.
+     *
+     * Inputs are taken from the source and opened just in time by an InputPrefetcher, and
+     * closed as soon as they are counted. Inputs that cannot be opened or fail while being read
+     * are marked unhealthy.
+     *
+     * @param inputs The inputs to count; nothing is kept of an input once it is counted but
+     * what the returned store holds for the report.
+     * @param options Options used to open the inputs.
+     * @param groups If set, healthy inputs are added to their group instead of the store.
+     * @param cache If set, unchanged files are answered from it and new results stored in it.
+     * @param progress If set, the progress of the count is published to it.
+     * @param onCounted If set, each counter is handed to it as soon as its input is counted,
+     * instead of being stored.
+     * @param stats If set, each input is measured for it.
+     * @return The counted inputs.
+     */
+    inline auto doCount(ccwc::argument_parser::InputSource& inputs,
+                        const InputStreamOptions& options, CounterGroups* groups = nullptr,
+                        ResultCache* cache = nullptr, ProgressTracker* progress = nullptr,
+                        const CountedCallback& onCounted = {},
+                        StatisticsRecorder*    stats     = nullptr) -> ResultStore
+    {
+        ResultStore     results;
+        auto            stateMachine = buildCounterStateMachineChain();
+        InputPrefetcher prefetcher(inputs, options, cache);
+
+        for (std::size_t i = 0; auto opened = prefetcher.next(); ++i)
+        {
+            auto& input = opened->mInput;
+            auto counter = countOpened(*opened, input, *stateMachine, cache, progress, stats);
+            if (groups != nullptr && input.mHealthStatus.mIsHealthy)
+            {
+                groups->add(input.mName, counter);
+                continue;
+            }
+            if (onCounted)
+            {
+                onCounted(i, input, counter);
+                continue;
+            }
+            results.add(input, counter);
+        }
+        return results;
+    }
+
+    /**
+     * @brief Count every regular file below the given directories.
+     *
+     * The trees are walked by one DirectoryWalker, which takes the inputs from the source as
+     * its threads run out of directories, while this thread counts the files found so far, so
+     * traversal and counting overlap. Inputs that are not directories are counted as they are.
+     * The files of each input are reported sorted by path, so the output does not depend on
+     * the order in which the walker threads found them.
+     *
+     * @param inputs The inputs to walk.
+     * @param options Options used to open the files.
+     * @param walkOptions Which files to count.
+     * @param groups If set, healthy files are added to their group instead of being listed.
+     * @param cache If set, unchanged files are answered from it and new results stored in it.
+     * @param progress If set, the progress of the count is published to it.
+     * @param onCounted If set, each file is handed to it as soon as it is counted, in the order
+     * they were found, instead of being stored.
+     * @param stats If set, each file is measured for it.
+     * @return The counted files.
      */
-    inline auto doCount(const std::vector<ccwc::argument_parser::InputDataObject>& inputDataObjects)
-        -> std::vector<Counter>
+    inline auto doCountRecursive(
+        ccwc::argument_parser::InputSource& inputs, const InputStreamOptions& options,
+        const WalkOptions& walkOptions,
+        CounterGroups* groups = nullptr, ResultCache* cache = nullptr,
+        ProgressTracker* progress = nullptr, const CountedCallback& onCounted = {},
+        StatisticsRecorder* stats = nullptr) -> ResultStore
     {
-        std::vector<Counter> counters;
-        counters.reserve(inputDataObjects.size());
+        ResultStore              results;
+        std::vector<std::size_t> resultRoots; // the input each result was found below
+        std::size_t              counted{0};
 
         auto stateMachine = buildCounterStateMachineChain();
 
-        for (const auto& inputDataObject : inputDataObjects)
+        auto keep = [&](const ccwc::argument_parser::InputDataObject& input,
+                        const Counter& counter, std::size_t root,
+                        std::size_t rootLength = ResultStore::NO_ROOT) {
+            if (groups != nullptr && input.mHealthStatus.mIsHealthy)
+            {
+                groups->add(input.mName, counter);
+            }
+            else if (onCounted)
+            {
+                onCounted(counted++, input, counter);
+            }
+            else
+            {
+                results.add(input, counter, rootLength);
+                resultRoots.push_back(root);
+            }
+        };
+
+        // The standard input and inputs that failed already are not walked but passed through
+        // the walker, which reports them back in their place; they wait here until then.
+        using PassedInput = std::pair<std::size_t, ccwc::argument_parser::InputDataObject>;
+        std::mutex              passedMutex;
+        std::deque<PassedInput> passed;
+        std::size_t             taken{0};
+
+        DirectoryWalker walker(
+            [&]() -> std::optional<WalkRoot> {
+                auto input = inputs.next();
+                if (!input.has_value())
+                {
+                    return std::nullopt;
+                }
+                std::size_t root = taken++;
+                if (!input->mHealthStatus.mIsHealthy || input->mIsStdin)
+                {
+                    std::lock_guard lock(passedMutex);
+                    passed.emplace_back(root, std::move(input.value()));
+                    return WalkRoot{"", root, false};
+                }
+                return WalkRoot{std::move(input->mName), root, true};
+            },
+            walkOptions);
+
+        while (auto entry = walker.next())
         {
-            auto counter = Counter();
-            while (inputDataObject.mInputStream->good())
+            std::optional<ccwc::argument_parser::InputDataObject> passedInput;
             {
-                auto byte = inputDataObject.mInputStream->nextByte();
-                if (!byte.has_value())
+                std::lock_guard lock(passedMutex);
+                if (!passed.empty() && passed.front().first == entry->mRoot)
                 {
-                    break;
+                    passedInput = std::move(passed.front().second);
+                    passed.pop_front();
                 }
-                if (!inputDataObject.mHealthStatus.mIsHealthy)
+            }
+            if (passedInput.has_value())
+            {
+                auto opened  = openInput(passedInput.value(), options, cache);
+                auto counter = countOpened(opened, passedInput.value(), *stateMachine, cache,
+                                           progress, stats);
+                keep(passedInput.value(), counter, entry->mRoot);
+                continue;
+            }
+
+            ccwc::argument_parser::InputDataObject file{
+                entry->mPath, false, ccwc::argument_parser::HealthStatus(true, "")};
+            Counter counter;
+            if (entry->mErrno != 0)
+            {
+                file.mHealthStatus = ccwc::argument_parser::HealthStatus(entry->mErrno);
+            }
+            else
+            {
+                auto opened = openInput(file, options, cache);
+                counter     = countOpened(opened, file, *stateMachine, cache, progress, stats);
+            }
+            // A root that is not a directory is reported as it is, like a named input.
+            keep(file, counter, entry->mRoot,
+                 entry->mRootLength == entry->mPath.size() ? ResultStore::NO_ROOT
+                                                           : entry->mRootLength);
+        }
+
+        std::vector<std::size_t> order(results.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return resultRoots[a] != resultRoots[b] ? resultRoots[a] < resultRoots[b]
+                                                    : results.name(a) < results.name(b);
+        });
+        results.reorder(std::move(order));
+        return results;
+    }
+
+    /**
+     * @brief Count every regular file inside the given tar archives.
+     *
+     * Each healthy archive is replaced by one input data object per member (named
+     * `archive.tar:path/in/archive`), so the result can be formatted like any list of files.
+     * Archives that could not be opened are kept as they are; an archive that turns out to be
+     * malformed is reported as an unhealthy entry after the members read so far.
+     *
+     * @param inputs The archives.
+     * @param options Options used to open the archives.
+     * @param groups If set, members are added to their group instead of being listed.
+     * @param progress If set, the progress of the count is published to it.
+     * @param onCounted If set, each member is handed to it as soon as it is counted instead of
+     * being stored.
+     * @param stats If set, each member is measured for it.
+     * @return The counted members.
+     */
+    inline auto doCountArchives(
+        ccwc::argument_parser::InputSource& inputs, const InputStreamOptions& options,
+        CounterGroups* groups = nullptr, ProgressTracker* progress = nullptr,
+        const CountedCallback& onCounted = {},
+        StatisticsRecorder* stats = nullptr) -> ResultStore
+    {
+        ResultStore members;
+        std::size_t counted{0};
+
+        auto            stateMachine = buildCounterStateMachineChain();
+        InputPrefetcher prefetcher(inputs, options);
+
+        auto keep = [&](const ccwc::argument_parser::InputDataObject& input,
+                        const Counter& counter, std::size_t rootLength = ResultStore::NO_ROOT) {
+            if (onCounted)
+            {
+                onCounted(counted++, input, counter);
+                return;
+            }
+            members.add(input, counter, rootLength);
+        };
+
+        while (auto opened = prefetcher.next())
+        {
+            auto& archive = opened->mInput;
+            if (!opened->mStream)
+            {
+                archive.mHealthStatus = opened->mHealthStatus;
+                keep(archive, Counter());
+                continue;
+            }
+
+            TarArchiveReader reader(*opened->mStream);
+            // Members are named "a.tar:path" ("-:path" for the standard input).
+            std::size_t rootLength = archive.mIsStdin ? 1 : archive.mName.size();
+            try
+            {
+                while (auto member = reader.nextMember())
                 {
-                    break;
+                    if (progress != nullptr)
+                    {
+                        progress->startInput(member->name());
+                    }
+                    InputMeasurement measured;
+                    if (stats != nullptr)
+                    {
+                        measured = stats->start(&*member);
+                    }
+                    auto counter = countStream(*member, *stateMachine, progress);
+                    if (progress != nullptr)
+                    {
+                        progress->finishInput(counter);
+                    }
+                    if (stats != nullptr)
+                    {
+                        stats->finish(member->name(), measured, &*member, counter);
+                    }
+                    if (groups != nullptr)
+                    {
+                        groups->add(member->name(), counter);
+                        continue;
+                    }
+                    keep({member->name(), false, ccwc::argument_parser::HealthStatus(true, "")},
+                         counter, rootLength);
                 }
-                stateMachine->updateState(byte.value());
-                stateMachine->updateCounter(counter);
             }
-            // Finalize to handle any remaining buffered data
-            stateMachine->finalize(counter);
-            stateMachine->reset();
-            counters.push_back(counter);
+            catch (const ccwc::exception::FileOperationException& e)
+            {
+                stateMachine->reset();
+                archive.mHealthStatus = ccwc::argument_parser::HealthStatus(false, e.what());
+                keep(archive, Counter());
+            }
         }
 
-        return counters;
+        return members;
     }
 } // namespace ccwc::algorithm
 
-#endif // CCWC_ALGORITHM_PROCESSOR_HPP
\ No newline at end of file
+#endif // CCWC_ALGORITHM_PROCESSOR_HPP
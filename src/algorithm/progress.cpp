@@ -0,0 +1,177 @@
+#include "progress.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <pthread.h>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+        /**
+         * @brief A file modified this recently is taken to be still being written.
+         */
+        constexpr time_t SETTLE_SECONDS = 2;
+
+        /**
+         * @brief The signals the monitor waits for.
+         */
+        auto monitoredSignals() -> sigset_t
+        {
+            sigset_t signals{};
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGUSR1);
+            sigaddset(&signals, SIGINT);
+            return signals;
+        }
+    } // namespace detail
+
+    ProgressTracker::ProgressTracker(std::size_t inputs, std::uint64_t expectedBytes)
+        : m_inputs(inputs), m_expected_bytes(expectedBytes),
+          m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    auto ProgressTracker::startInput(const std::string& name) -> void
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current = name;
+    }
+
+    auto ProgressTracker::finishInput(const Counter& counter) -> void
+    {
+        m_finished_bytes.fetch_add(counter.bytes, std::memory_order_relaxed);
+        m_words.fetch_add(counter.words, std::memory_order_relaxed);
+        m_lines.fetch_add(counter.lines, std::memory_order_relaxed);
+        m_multibyte.fetch_add(counter.multibyte, std::memory_order_relaxed);
+        m_finished.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto ProgressTracker::partial() const -> Counter
+    {
+        Counter counter;
+        counter.bytes     = m_finished_bytes.load(std::memory_order_relaxed);
+        counter.words     = m_words.load(std::memory_order_relaxed);
+        counter.lines     = m_lines.load(std::memory_order_relaxed);
+        counter.multibyte = m_multibyte.load(std::memory_order_relaxed);
+        return counter;
+    }
+
+    auto ProgressTracker::describe() const -> std::string
+    {
+        Counter       counter  = partial();
+        std::uint64_t bytes    = m_bytes.load(std::memory_order_relaxed);
+        std::size_t   finished = m_finished.load(std::memory_order_relaxed);
+        double        seconds  = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                               m_start)
+                               .count();
+        double rate = seconds > 0 ? static_cast<double>(bytes) / seconds : 0;
+
+        std::ostringstream line;
+        line.precision(1);
+        line << std::fixed << "ccwc: " << finished;
+        if (m_inputs > 0)
+        {
+            line << '/' << m_inputs;
+        }
+        line << " files, " << bytes << " bytes in " << seconds << "s ("
+             << rate / detail::MEBIBYTE << " MiB/s)";
+        if (m_expected_bytes > 0 && bytes <= m_expected_bytes)
+        {
+            double percent =
+                100.0 * static_cast<double>(bytes) / static_cast<double>(m_expected_bytes);
+            double remaining = static_cast<double>(m_expected_bytes - bytes);
+            line << ", " << percent << "% done";
+            if (rate > 0)
+            {
+                line << ", ETA " << remaining / rate << 's';
+            }
+        }
+        line << "; " << counter.lines << " lines, " << counter.words << " words in finished files";
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_current.empty())
+        {
+            line << "; at " << m_current;
+        }
+        line << '\n';
+        return line.str();
+    }
+
+    auto inputSizes(const std::vector<ccwc::argument_parser::InputDataObject>& inputs)
+        -> InputSizes
+    {
+        InputSizes sizes;
+        time_t     settledBefore = std::time(nullptr) - detail::SETTLE_SECONDS;
+        for (const auto& input : inputs)
+        {
+            struct stat info{};
+            if (input.mIsStdin)
+            {
+                sizes.mAllKnown = false;
+            }
+            else if (::stat(input.mName.c_str(), &info) == 0)
+            {
+                if (S_ISREG(info.st_mode))
+                {
+                    sizes.mBytes += static_cast<std::uint64_t>(info.st_size);
+                    sizes.mSettled = sizes.mSettled && info.st_mtime < settledBefore;
+                }
+                else
+                {
+                    sizes.mAllKnown = false;
+                }
+            }
+        }
+        return sizes;
+    }
+
+    ProgressMonitor::ProgressMonitor(ProgressTracker& tracker, bool periodic,
+                                     std::function<void(const Counter&)> interrupted)
+        : m_tracker(tracker), m_periodic(periodic), m_interrupted(std::move(interrupted))
+    {
+        sigset_t signals = detail::monitoredSignals();
+        ::pthread_sigmask(SIG_BLOCK, &signals, &m_previous_mask);
+        m_thread = std::thread([this] { run(); });
+    }
+
+    ProgressMonitor::~ProgressMonitor()
+    {
+        m_stop.store(true);
+        // Wake the thread up; it sees m_stop before reporting anything.
+        ::pthread_kill(m_thread.native_handle(), SIGUSR1);
+        m_thread.join();
+        ::pthread_sigmask(SIG_SETMASK, &m_previous_mask, nullptr);
+    }
+
+    auto ProgressMonitor::run() -> void
+    {
+        sigset_t signals = detail::monitoredSignals();
+        timespec second{1, 0};
+        while (true)
+        {
+            int signal = ::sigtimedwait(&signals, nullptr, m_periodic ? &second : nullptr);
+            if (m_stop.load())
+            {
+                return;
+            }
+            if (signal == SIGINT)
+            {
+                std::fputs(m_tracker.describe().c_str(), stderr);
+                m_interrupted(m_tracker.partial());
+                std::_Exit(128 + SIGINT); // NOLINT(*-magic-numbers)
+            }
+            if (signal == SIGUSR1 || (signal < 0 && errno == EAGAIN))
+            {
+                std::fputs(m_tracker.describe().c_str(), stderr);
+            }
+        }
+    }
+
+} // namespace ccwc::algorithm
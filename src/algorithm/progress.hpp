@@ -0,0 +1,157 @@
+#ifndef CCWC_ALGORITHM_PROGRESS_HPP
+#define CCWC_ALGORITHM_PROGRESS_HPP
+
+#include "argument_parser/input_objects.hpp"
+#include "counter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Bytes between two progress updates of an input counted byte by byte.
+     */
+    constexpr std::size_t PROGRESS_GRANULARITY = static_cast<std::size_t>(64 * 1024);
+
+    /**
+     * @brief How far a count has got, published by the counting thread and read by another.
+     *
+     * The byte count changes all the time, so it and the counts of the finished inputs are
+     * relaxed atomics: the reader only needs a recent value, not one consistent with the rest.
+     * The name of the current input changes once per input and sits behind a mutex.
+     */
+    class ProgressTracker
+    {
+      private:
+        std::atomic<std::uint64_t>            m_bytes{0};
+        std::atomic<std::uint64_t>            m_finished_bytes{0};
+        std::atomic<std::uint64_t>            m_words{0};
+        std::atomic<std::uint64_t>            m_lines{0};
+        std::atomic<std::uint64_t>            m_multibyte{0};
+        std::atomic<std::size_t>              m_finished{0};
+        std::size_t                           m_inputs;
+        std::uint64_t                         m_expected_bytes;
+        std::chrono::steady_clock::time_point m_start;
+        mutable std::mutex                    m_mutex;
+        std::string                           m_current;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param inputs Number of inputs, 0 if unknown (recursive counts).
+         * @param expectedBytes Sum of the input sizes, 0 if unknown.
+         */
+        ProgressTracker(std::size_t inputs, std::uint64_t expectedBytes);
+
+        /**
+         * @brief An input starts being counted.
+         */
+        auto startInput(const std::string& name) -> void;
+
+        /**
+         * @brief Bytes of the current input were counted.
+         */
+        auto addBytes(std::uint64_t bytes) -> void
+        {
+            m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief The current input is counted; its bytes were already added.
+         */
+        auto finishInput(const Counter& counter) -> void;
+
+        /**
+         * @brief The counts of the finished inputs.
+         */
+        [[nodiscard]] auto partial() const -> Counter;
+
+        /**
+         * @brief One line describing the progress: throughput, ETA, partial counts.
+         */
+        [[nodiscard]] auto describe() const -> std::string;
+    };
+
+    /**
+     * @brief Sizes of the inputs, known before they are counted.
+     */
+    struct InputSizes
+    {
+        /**
+         * @brief Sum of the sizes of the inputs that are regular files.
+         */
+        std::uint64_t mBytes{0};
+
+        /**
+         * @brief Whether every input is a regular file (or missing), so mBytes bounds the bytes
+         * that are going to be counted.
+         */
+        bool mAllKnown{true};
+
+        /**
+         * @brief Whether no regular file was modified in the last 2 seconds. A file that is
+         * still being written can grow past mBytes before it is counted.
+         */
+        bool mSettled{true};
+    };
+
+    /**
+     * @brief The sizes of the inputs, from one stat() each.
+     */
+    auto inputSizes(const std::vector<ccwc::argument_parser::InputDataObject>& inputs)
+        -> InputSizes;
+
+    /**
+     * @brief Reports a ProgressTracker on SIGUSR1 (like dd), every second with `--progress`,
+     * and prints the partial totals on SIGINT.
+     *
+     * SIGUSR1 and SIGINT are blocked and then waited for with sigtimedwait() on a thread of
+     * the monitor, so nothing runs in signal handler context. The monitor must be created
+     * before any other thread, which inherit the blocked signals.
+     */
+    class ProgressMonitor
+    {
+      private:
+        ProgressTracker&                    m_tracker;
+        bool                                m_periodic;
+        std::function<void(const Counter&)> m_interrupted;
+        sigset_t                            m_previous_mask{};
+        std::atomic<bool>                   m_stop{false};
+        std::thread                         m_thread;
+
+        auto run() -> void;
+
+      public:
+        /**
+         * @brief Constructor: blocks the signals and starts waiting for them.
+         * @param tracker The progress to report.
+         * @param periodic Also report every second.
+         * @param interrupted Called with the partial totals on SIGINT, before the process exits.
+         */
+        ProgressMonitor(ProgressTracker& tracker, bool periodic,
+                        std::function<void(const Counter&)> interrupted);
+
+        /**
+         * @brief Destructor: stops the monitor thread and unblocks the signals.
+         */
+        ~ProgressMonitor();
+
+        ProgressMonitor(const ProgressMonitor&)                    = delete;
+        auto operator=(const ProgressMonitor&) -> ProgressMonitor& = delete;
+        ProgressMonitor(ProgressMonitor&&)                         = delete;
+        auto operator=(ProgressMonitor&&) -> ProgressMonitor&      = delete;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_PROGRESS_HPP
@@ -0,0 +1,396 @@
+#include "result_cache.hpp"
+
+#include "exception/exception.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr std::uint32_t CACHE_MAGIC         = 0x31435743; // "CWC1"
+        constexpr std::size_t   CACHE_RECORD_SIZE   = 88;
+        constexpr std::size_t   CACHE_FLUSH_SIZE    = 256 * CACHE_RECORD_SIZE;
+        constexpr std::size_t   MIN_COMPACT_RECORDS = 1024;
+        constexpr std::uint64_t FNV_OFFSET_BASIS    = 0xcbf29ce484222325ULL;
+        constexpr std::uint64_t FNV_PRIME           = 0x100000001b3ULL;
+        constexpr std::int64_t  NANOSECONDS         = 1'000'000'000;
+
+        /**
+         * @brief The coarsest timestamp granularity of the common file systems (FAT keeps the
+         * mtime in 2 second steps; ext3 and HFS+ in seconds).
+         */
+        constexpr std::int64_t TIMESTAMP_GRANULARITY_NS = 2 * NANOSECONDS;
+
+        auto nanoseconds(const timespec& time) -> std::int64_t
+        {
+            return (static_cast<std::int64_t>(time.tv_sec) * NANOSECONDS) + time.tv_nsec;
+        }
+
+        constexpr const char* CACHE_FILE = "/counts.v1";
+        constexpr const char* LOCK_FILE  = "/lock";
+
+        using CacheRecord = std::array<unsigned char, CACHE_RECORD_SIZE>;
+
+        /**
+         * @brief FNV-1a over the record without its checksum field.
+         */
+        auto checksum(const unsigned char* record) -> std::uint64_t
+        {
+            std::uint64_t hash = FNV_OFFSET_BASIS;
+            for (std::size_t i = 0; i < CACHE_RECORD_SIZE - sizeof(std::uint64_t); ++i)
+            {
+                hash = (hash ^ record[i]) * FNV_PRIME; // NOLINT(*-pointer-arithmetic)
+            }
+            return hash;
+        }
+
+        /**
+         * @brief Lays out the fields of a record (native byte order, the cache is per machine).
+         */
+        class RecordCursor
+        {
+          private:
+            unsigned char* m_data;
+            std::size_t    m_offset{0};
+
+          public:
+            explicit RecordCursor(unsigned char* data) : m_data(data)
+            {
+            }
+
+            template <typename T> auto put(T value) -> RecordCursor&
+            {
+                std::memcpy(m_data + m_offset, &value, sizeof(T)); // NOLINT(*-pointer-arithmetic)
+                m_offset += sizeof(T);
+                return *this;
+            }
+
+            template <typename T> auto get(T& value) -> RecordCursor&
+            {
+                std::memcpy(&value, m_data + m_offset, sizeof(T)); // NOLINT(*-pointer-arithmetic)
+                m_offset += sizeof(T);
+                return *this;
+            }
+        };
+
+        auto encode(const CacheKey& key, const Counter& counter) -> CacheRecord
+        {
+            CacheRecord record{};
+            RecordCursor(record.data())
+                .put(CACHE_MAGIC)
+                .put(key.mMode)
+                .put(key.mDevice)
+                .put(key.mInode)
+                .put(key.mSize)
+                .put(key.mModifiedNs)
+                .put(key.mChangedNs)
+                .put(static_cast<std::uint64_t>(counter.bytes))
+                .put(static_cast<std::uint64_t>(counter.words))
+                .put(static_cast<std::uint64_t>(counter.lines))
+                .put(static_cast<std::uint64_t>(counter.multibyte));
+            std::uint64_t sum = checksum(record.data());
+            std::memcpy(record.data() + CACHE_RECORD_SIZE - sizeof(sum), &sum, sizeof(sum));
+            return record;
+        }
+
+        /**
+         * @brief Decode the record at `data` if it is intact.
+         */
+        auto decode(unsigned char* data, CacheKey& key, Counter& counter) -> bool
+        {
+            std::uint32_t magic{0};
+            std::uint64_t bytes{0};
+            std::uint64_t words{0};
+            std::uint64_t lines{0};
+            std::uint64_t multibyte{0};
+            std::uint64_t sum{0};
+            RecordCursor(data)
+                .get(magic)
+                .get(key.mMode)
+                .get(key.mDevice)
+                .get(key.mInode)
+                .get(key.mSize)
+                .get(key.mModifiedNs)
+                .get(key.mChangedNs)
+                .get(bytes)
+                .get(words)
+                .get(lines)
+                .get(multibyte)
+                .get(sum);
+            if (magic != CACHE_MAGIC || sum != checksum(data))
+            {
+                return false;
+            }
+            counter.bytes     = bytes;
+            counter.words     = words;
+            counter.lines     = lines;
+            counter.multibyte = multibyte;
+            return true;
+        }
+
+        /**
+         * @brief Write a whole buffer, retrying short writes.
+         */
+        auto writeAll(int fd, const unsigned char* data, std::size_t size) -> bool
+        {
+            while (size > 0)
+            {
+                ssize_t written = ::write(fd, data, size);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written; // NOLINT(*-pointer-arithmetic)
+                size -= static_cast<std::size_t>(written);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Read a whole file into memory.
+         */
+        auto readAll(int fd) -> std::vector<unsigned char>
+        {
+            constexpr std::size_t READ_SIZE = static_cast<std::size_t>(64 * 1024); // 64KiB
+
+            std::vector<unsigned char> data;
+            while (true)
+            {
+                std::size_t used = data.size();
+                data.resize(used + READ_SIZE);
+                ssize_t bytesRead = ::read(fd, data.data() + used, READ_SIZE);
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    data.resize(used);
+                    continue;
+                }
+                data.resize(used + static_cast<std::size_t>(std::max<ssize_t>(bytesRead, 0)));
+                if (bytesRead <= 0)
+                {
+                    return data;
+                }
+            }
+        }
+    } // namespace detail
+
+    auto CacheFileIdHash::operator()(const CacheFileId& file) const noexcept -> std::size_t
+    {
+        std::uint64_t hash = detail::FNV_OFFSET_BASIS;
+        for (std::uint64_t part : {file.mDevice, file.mInode})
+        {
+            hash = (hash ^ part) * detail::FNV_PRIME;
+        }
+        return static_cast<std::size_t>(hash);
+    }
+
+    ResultCache::ResultCache(std::string directory) : m_directory(std::move(directory))
+    {
+        timespec now{};
+        ::clock_gettime(CLOCK_REALTIME, &now);
+        m_racy_since = detail::nanoseconds(now) - detail::TIMESTAMP_GRANULARITY_NS;
+
+        if (::mkdir(m_directory.c_str(), 0777) != 0 && errno != EEXIST) // NOLINT(*-magic-numbers)
+        {
+            throw ccwc::exception::FileOperationException(m_directory + ": " +
+                                                          std::strerror(errno));
+        }
+
+        std::size_t records = load();
+        if (records >= detail::MIN_COMPACT_RECORDS && records > 2 * m_entries.size())
+        {
+            compact();
+        }
+    }
+
+    ResultCache::~ResultCache()
+    {
+        flush();
+    }
+
+    auto ResultCache::lock(int operation) const -> FileDescriptor
+    {
+        std::string path = m_directory + detail::LOCK_FILE;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        FileDescriptor fd{::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666)};
+        if (!fd.valid())
+        {
+            throw ccwc::exception::FileOperationException(path + ": " + std::strerror(errno));
+        }
+        if (::flock(fd.get(), operation) != 0)
+        {
+            return FileDescriptor{};
+        }
+        return fd;
+    }
+
+    auto ResultCache::load() -> std::size_t
+    {
+        FileDescriptor guard = lock(LOCK_SH);
+        return readLog();
+    }
+
+    auto ResultCache::readLog() -> std::size_t
+    {
+        std::string path = m_directory + detail::CACHE_FILE;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        FileDescriptor fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (!fd.valid())
+        {
+            return 0; // no cache yet
+        }
+
+        std::vector<unsigned char> log = detail::readAll(fd.get());
+        std::size_t                records{0};
+        for (std::size_t offset = 0; offset + detail::CACHE_RECORD_SIZE <= log.size();)
+        {
+            CacheKey key;
+            Counter  counter;
+            if (detail::decode(log.data() + offset, key, counter))
+            {
+                // A later record of the same file wins unless its change time is older: a
+                // process that read the file before it was modified may append after one that
+                // read it afterwards.
+                auto [entry, added] = m_entries.try_emplace({key.mDevice, key.mInode},
+                                                            CachedResult{key, counter});
+                if (!added && key.mChangedNs >= entry->second.mKey.mChangedNs)
+                {
+                    entry->second = CachedResult{key, counter};
+                }
+                offset += detail::CACHE_RECORD_SIZE;
+                ++records;
+            }
+            else
+            {
+                ++offset; // resynchronise after a torn record
+            }
+        }
+        return records;
+    }
+
+    auto ResultCache::compact() -> void
+    {
+        FileDescriptor guard = lock(LOCK_EX | LOCK_NB);
+        if (!guard.valid())
+        {
+            return; // another process is using the cache; try again next time
+        }
+        // Pick up what other processes appended since the log was loaded.
+        readLog();
+
+        std::vector<unsigned char> log;
+        log.reserve(m_entries.size() * detail::CACHE_RECORD_SIZE);
+        for (const auto& [file, result] : m_entries)
+        {
+            auto record = detail::encode(result.mKey, result.mCounter);
+            log.insert(log.end(), record.begin(), record.end());
+        }
+
+        std::string path      = m_directory + detail::CACHE_FILE;
+        std::string temporary = path + "." + std::to_string(::getpid());
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        FileDescriptor fd{
+            ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)};
+        if (!fd.valid())
+        {
+            return;
+        }
+        if (!detail::writeAll(fd.get(), log.data(), log.size()) ||
+            ::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            ::unlink(temporary.c_str());
+        }
+    }
+
+    auto ResultCache::keyFor(const std::string& path, CompressionFormat format)
+        -> std::optional<CacheKey>
+    {
+        struct stat info{};
+        if (::stat(path.c_str(), &info) != 0)
+        {
+            return std::nullopt;
+        }
+        return keyOf(info, format);
+    }
+
+    auto ResultCache::keyOf(const struct stat& info, CompressionFormat format)
+        -> std::optional<CacheKey>
+    {
+        if (!S_ISREG(info.st_mode))
+        {
+            return std::nullopt;
+        }
+
+        CacheKey key;
+        key.mDevice     = static_cast<std::uint64_t>(info.st_dev);
+        key.mInode      = static_cast<std::uint64_t>(info.st_ino);
+        key.mSize       = static_cast<std::uint64_t>(info.st_size);
+        key.mModifiedNs = detail::nanoseconds(info.st_mtim);
+        key.mChangedNs  = detail::nanoseconds(info.st_ctim);
+        key.mMode       = static_cast<std::uint32_t>(format);
+        return key;
+    }
+
+    auto ResultCache::lookup(const CacheKey& key) const -> std::optional<Counter>
+    {
+        auto found = m_entries.find({key.mDevice, key.mInode});
+        if (found == m_entries.end() || !(found->second.mKey == key))
+        {
+            return std::nullopt;
+        }
+        return found->second.mCounter;
+    }
+
+    auto ResultCache::store(const CacheKey& key, const Counter& counter) -> void
+    {
+        if (key.mModifiedNs >= m_racy_since || key.mChangedNs >= m_racy_since)
+        {
+            return;
+        }
+        auto record = detail::encode(key, counter);
+        m_pending.insert(m_pending.end(), record.begin(), record.end());
+        if (m_pending.size() >= detail::CACHE_FLUSH_SIZE)
+        {
+            flush();
+        }
+    }
+
+    auto ResultCache::flush() -> void
+    {
+        if (m_pending.empty())
+        {
+            return;
+        }
+
+        // The cache only saves work; failing to extend it must not fail the count.
+        try
+        {
+            FileDescriptor guard = lock(LOCK_SH);
+            std::string    path  = m_directory + detail::CACHE_FILE;
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+            FileDescriptor fd{
+                ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666)};
+            if (fd.valid())
+            {
+                detail::writeAll(fd.get(), m_pending.data(), m_pending.size());
+            }
+        }
+        catch (const ccwc::exception::FileOperationException&)
+        {
+        }
+        m_pending.clear();
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,169 @@
+#ifndef CCWC_ALGORITHM_RESULT_CACHE_HPP
+#define CCWC_ALGORITHM_RESULT_CACHE_HPP
+
+#include "compressed_input_stream.hpp"
+#include "counter.hpp"
+#include "file_descriptor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <sys/stat.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Identity of a file's content as far as the cache is concerned.
+     *
+     * Any write to the file changes its ctime, so a matching key means the content is the one
+     * that was counted, as long as the write happened in a later tick of the file system clock
+     * than the count: see ResultCache::store().
+     */
+    struct CacheKey
+    {
+        std::uint64_t mDevice{0};
+        std::uint64_t mInode{0};
+        std::uint64_t mSize{0};
+        std::int64_t  mModifiedNs{0};
+        std::int64_t  mChangedNs{0};
+        std::uint32_t mMode{0}; // How the file was read (the decompression format).
+
+        auto operator==(const CacheKey& other) const -> bool = default;
+    };
+
+    /**
+     * @brief The file a CacheKey belongs to; the cache keeps one result per file.
+     */
+    struct CacheFileId
+    {
+        std::uint64_t mDevice{0};
+        std::uint64_t mInode{0};
+
+        auto operator==(const CacheFileId& other) const -> bool = default;
+    };
+
+    /**
+     * @brief Hash of a CacheFileId.
+     */
+    struct CacheFileIdHash
+    {
+        auto operator()(const CacheFileId& file) const noexcept -> std::size_t;
+    };
+
+    /**
+     * @brief On-disk cache of the counters of regular files, stored in a directory.
+     *
+     * The cache is an append-only log of fixed-size, checksummed records (`counts.v1`). Only the
+     * newest record of each file (device and inode) is kept: a file that was modified is stored
+     * under a new key, which supersedes the record of its previous content. New results are
+     * appended with a single O_APPEND write per batch while holding a shared lock on `lock`, so
+     * several ccwc processes can use the same directory at once; a torn record is skipped when
+     * the log is loaded. When most of the log is superseded records, it is compacted into a new
+     * file with one record per file under an exclusive lock and renamed over the old one.
+     *
+     * lookup() only reads the state loaded at construction, so it may run on another thread
+     * than store().
+     */
+    class ResultCache
+    {
+      private:
+        /**
+         * @brief The newest result known for a file.
+         */
+        struct CachedResult
+        {
+            CacheKey mKey;
+            Counter  mCounter;
+        };
+
+        std::string                                                    m_directory;
+        std::unordered_map<CacheFileId, CachedResult, CacheFileIdHash> m_entries;
+        std::vector<unsigned char>                                     m_pending;
+        std::int64_t                                                   m_racy_since{0};
+
+        /**
+         * @brief Take the lock file of the cache directory.
+         */
+        [[nodiscard]] auto lock(int operation) const -> FileDescriptor;
+
+        /**
+         * @brief Read the log into m_entries under a shared lock.
+         * @return The number of valid records read.
+         */
+        auto load() -> std::size_t;
+
+        /**
+         * @brief Read the log into m_entries, keeping the newest record of each file; the caller
+         * holds the lock.
+         * @return The number of valid records read.
+         */
+        auto readLog() -> std::size_t;
+
+        /**
+         * @brief Rewrite the log with one record per file, if no other process holds the lock.
+         */
+        auto compact() -> void;
+
+      public:
+        /**
+         * @brief Constructor: creates the directory if needed and loads the cache.
+         * @param directory The cache directory.
+         * @throws ccwc::exception::FileOperationException if the directory cannot be used.
+         */
+        explicit ResultCache(std::string directory);
+
+        /**
+         * @brief Destructor: writes the results that are still pending.
+         */
+        ~ResultCache();
+
+        ResultCache(const ResultCache&)                    = delete;
+        auto operator=(const ResultCache&) -> ResultCache& = delete;
+        ResultCache(ResultCache&&)                         = delete;
+        auto operator=(ResultCache&&) -> ResultCache&      = delete;
+
+        /**
+         * @brief The key of a file, from a single stat(); only good for a lookup, since the path
+         * may name another file by the time it is opened.
+         * @param path Path of the file.
+         * @param format How the file is going to be read.
+         * @return The key, or std::nullopt for anything but an existing regular file.
+         */
+        [[nodiscard]] static auto keyFor(const std::string& path, CompressionFormat format)
+            -> std::optional<CacheKey>;
+
+        /**
+         * @brief The key of an opened file, from the fstat() of the descriptor its counts are
+         * read from; the key a result is stored under.
+         * @return The key, or std::nullopt for anything but a regular file.
+         */
+        [[nodiscard]] static auto keyOf(const struct stat& info, CompressionFormat format)
+            -> std::optional<CacheKey>;
+
+        /**
+         * @brief The cached counter of a file, if it is known.
+         */
+        [[nodiscard]] auto lookup(const CacheKey& key) const -> std::optional<Counter>;
+
+        /**
+         * @brief Remember the counter of a file; written out in batches.
+         *
+         * A file whose mtime or ctime is within the timestamp granularity of the start of the run
+         * is not remembered: it may be written again within the same tick after it was read,
+         * leaving its key unchanged ("racy timestamps"). It is counted again next time.
+         */
+        auto store(const CacheKey& key, const Counter& counter) -> void;
+
+        /**
+         * @brief Append the pending results to the log.
+         */
+        auto flush() -> void;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_RESULT_CACHE_HPP
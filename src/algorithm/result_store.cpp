@@ -0,0 +1,95 @@
+#include "result_store.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        const ccwc::argument_parser::HealthStatus HEALTHY_INPUT{};
+    } // namespace detail
+
+    auto ResultStore::reserve(std::size_t inputs, std::size_t nameBytes) -> void
+    {
+        m_names.reserve(nameBytes);
+        m_name_ends.reserve(inputs);
+        m_counters.reserve(inputs);
+    }
+
+    auto ResultStore::add(std::string_view name, bool isStdin,
+                          const ccwc::argument_parser::HealthStatus& health,
+                          const Counter& counter, std::size_t rootLength) -> void
+    {
+        std::size_t index = m_counters.size();
+        if (!m_order.empty())
+        {
+            m_order.push_back(index);
+        }
+        if (isStdin)
+        {
+            m_stdin.push_back(index);
+        }
+        if (!health.mIsHealthy)
+        {
+            m_failures.emplace_back(index, health);
+        }
+        m_names.insert(m_names.end(), name.begin(), name.end());
+        m_name_ends.push_back(m_names.size());
+        m_counters.push_back(counter);
+        if (rootLength != NO_ROOT || !m_roots.empty())
+        {
+            // Only kept once some input has a root; the inputs before it were named directly.
+            m_roots.resize(index, NO_ROOT);
+            m_roots.push_back(rootLength);
+        }
+    }
+
+    auto ResultStore::reorder(std::vector<std::size_t> order) -> void
+    {
+        if (!m_order.empty())
+        {
+            for (auto& index : order)
+            {
+                index = m_order[index];
+            }
+        }
+        m_order = std::move(order);
+    }
+
+    auto ResultStore::rootLength(std::size_t index) const -> std::size_t
+    {
+        std::size_t input = stored(index);
+        if (input < m_roots.size() && m_roots[input] != NO_ROOT)
+        {
+            return m_roots[input];
+        }
+        std::string_view path  = name(index);
+        std::size_t      slash = path.rfind('/');
+        if (slash == std::string_view::npos)
+        {
+            return 0;
+        }
+        return slash == 0 ? 1 : slash;
+    }
+
+    auto ResultStore::isStdin(std::size_t index) const -> bool
+    {
+        return std::binary_search(m_stdin.begin(), m_stdin.end(), stored(index));
+    }
+
+    auto ResultStore::health(std::size_t index) const
+        -> const ccwc::argument_parser::HealthStatus&
+    {
+        std::size_t input   = stored(index);
+        auto        failure = std::lower_bound(
+            m_failures.begin(), m_failures.end(), input,
+            [](const auto& entry, std::size_t wanted) { return entry.first < wanted; });
+        if (failure == m_failures.end() || failure->first != input)
+        {
+            return detail::HEALTHY_INPUT;
+        }
+        return failure->second;
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,120 @@
+#ifndef CCWC_ALGORITHM_RESULT_STORE_HPP
+#define CCWC_ALGORITHM_RESULT_STORE_HPP
+
+#include "argument_parser/input_objects.hpp"
+#include "counter.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief The counted inputs of a report, kept as compactly as possible.
+     *
+     * A structure of arrays: the names are stored back to back in one arena and found by their
+     * end offset, the counters sit in a parallel array, and the rare inputs that are the
+     * standard input or failed are listed apart. An input costs its name plus 40 bytes, where
+     * an InputDataObject and its Counter cost over a hundred, with a heap allocation per name.
+     * Sorting the inputs only stores the new order, 8 bytes per input, instead of a copy, and
+     * inputs found below a root (by a recursive walk or inside an archive) take 8 more bytes for
+     * the length of that root.
+     */
+    class ResultStore
+    {
+      private:
+        std::vector<char>                                                        m_names;
+        std::vector<std::size_t>                                                 m_name_ends;
+        std::vector<Counter>                                                     m_counters;
+        std::vector<std::size_t>                                                 m_stdin;
+        std::vector<std::pair<std::size_t, ccwc::argument_parser::HealthStatus>> m_failures;
+        std::vector<std::size_t>                                                 m_order;
+        std::vector<std::size_t>                                                 m_roots;
+
+        /**
+         * @brief Where the input shown at `position` is stored; m_order is empty while the
+         * inputs are in the order they were added.
+         */
+        [[nodiscard]] auto stored(std::size_t position) const -> std::size_t
+        {
+            return m_order.empty() ? position : m_order[position];
+        }
+
+      public:
+        /**
+         * @brief Root length of an input that was named directly rather than found below a root.
+         */
+        static constexpr std::size_t NO_ROOT = static_cast<std::size_t>(-1);
+
+        /**
+         * @brief Make room for `inputs` inputs whose names take `nameBytes` bytes in total.
+         */
+        auto reserve(std::size_t inputs, std::size_t nameBytes = 0) -> void;
+
+        /**
+         * @brief Add an input.
+         * @param health Kept only if the input failed.
+         * @param rootLength Length of the prefix of `name` that is the root the input was found
+         * below, or NO_ROOT if it was named directly.
+         */
+        auto add(std::string_view name, bool isStdin,
+                 const ccwc::argument_parser::HealthStatus& health, const Counter& counter,
+                 std::size_t rootLength = NO_ROOT) -> void;
+
+        /**
+         * @brief Add an input described by an input data object.
+         */
+        auto add(const ccwc::argument_parser::InputDataObject& input, const Counter& counter,
+                 std::size_t rootLength = NO_ROOT) -> void
+        {
+            add(input.mName, input.mIsStdin, input.mHealthStatus, counter, rootLength);
+        }
+
+        /**
+         * @brief Show the inputs in the given order; `order[i]` is the index of the input that
+         * comes i-th. Inputs added afterwards come last.
+         */
+        auto reorder(std::vector<std::size_t> order) -> void;
+
+        [[nodiscard]] auto size() const -> std::size_t
+        {
+            return m_counters.size();
+        }
+
+        [[nodiscard]] auto name(std::size_t index) const -> std::string_view
+        {
+            std::size_t input = stored(index);
+            std::size_t begin = input == 0 ? 0 : m_name_ends[input - 1];
+            return {m_names.data() + begin, m_name_ends[input] - begin};
+        }
+
+        [[nodiscard]] auto counter(std::size_t index) const -> const Counter&
+        {
+            return m_counters[stored(index)];
+        }
+
+        /**
+         * @brief Length of the prefix of the name of the input at `index` that is its root: the
+         * root it was found below, or the directory of an input named directly (0 if its name has
+         * no directory).
+         */
+        [[nodiscard]] auto rootLength(std::size_t index) const -> std::size_t;
+
+        /**
+         * @brief Whether the input at `index` is the standard input.
+         */
+        [[nodiscard]] auto isStdin(std::size_t index) const -> bool;
+
+        /**
+         * @brief The health of the input at `index`.
+         */
+        [[nodiscard]] auto health(std::size_t index) const
+            -> const ccwc::argument_parser::HealthStatus&;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_RESULT_STORE_HPP
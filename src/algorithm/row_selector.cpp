@@ -0,0 +1,149 @@
+#include "row_selector.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace ccwc::algorithm
+{
+
+    auto parseSortKey(std::string_view name) -> std::optional<SortKey>
+    {
+        if (name == "lines")
+        {
+            return SortKey::LINES;
+        }
+        if (name == "words")
+        {
+            return SortKey::WORDS;
+        }
+        if (name == "chars")
+        {
+            return SortKey::CHARS;
+        }
+        if (name == "bytes")
+        {
+            return SortKey::BYTES;
+        }
+        return std::nullopt;
+    }
+
+    RowSelector::RowSelector(SelectionOptions options, bool byPath)
+        : m_options(options), m_by_path(byPath)
+    {
+        if (m_options.mTop.has_value() && !m_options.mSortBy.has_value())
+        {
+            m_options.mSortBy = SortKey::BYTES;
+        }
+    }
+
+    auto RowSelector::keyOf(const Counter& counter) const -> std::size_t
+    {
+        if (!m_options.mSortBy.has_value())
+        {
+            return 0;
+        }
+        switch (m_options.mSortBy.value())
+        {
+        case SortKey::LINES:
+            return counter.lines;
+        case SortKey::WORDS:
+            return counter.words;
+        case SortKey::CHARS:
+            return counter.multibyte;
+        case SortKey::BYTES:
+            return counter.bytes;
+        }
+        return 0;
+    }
+
+    auto RowSelector::precedes(const Rank& a, const Rank& b) const -> bool
+    {
+        if (a.mKey != b.mKey)
+        {
+            return a.mKey > b.mKey;
+        }
+        if (m_by_path && a.mName != b.mName)
+        {
+            return a.mName < b.mName;
+        }
+        return a.mIndex < b.mIndex;
+    }
+
+    auto RowSelector::add(std::size_t index, const ccwc::argument_parser::InputDataObject& input,
+                          const Counter& counter) -> void
+    {
+        if (!input.mHealthStatus.mIsHealthy)
+        {
+            m_failures.add(input, counter);
+            return;
+        }
+
+        const Counter& minimum = m_options.mMinimum;
+        if (counter.lines < minimum.lines || counter.words < minimum.words ||
+            counter.multibyte < minimum.multibyte || counter.bytes < minimum.bytes)
+        {
+            return;
+        }
+
+        std::size_t key = keyOf(counter);
+        if (!m_options.mTop.has_value())
+        {
+            m_kept.add(input, counter);
+            m_kept_indices.push_back(index);
+            return;
+        }
+
+        // The root of the heap is the row printed last; a row that would come after it when the
+        // heap is full is dropped without copying its name.
+        auto later = [this](const Row& a, const Row& b) { return precedes(a.rank(), b.rank()); };
+        if (m_heap.size() == m_options.mTop.value())
+        {
+            if (m_heap.empty() || !precedes({key, index, input.mName}, m_heap.front().rank()))
+            {
+                return;
+            }
+            std::pop_heap(m_heap.begin(), m_heap.end(), later);
+            m_heap.pop_back();
+        }
+        m_heap.push_back({key, index, input.mName, input.mIsStdin, counter});
+        std::push_heap(m_heap.begin(), m_heap.end(), later);
+    }
+
+    auto RowSelector::finish() -> ResultStore
+    {
+        ResultStore rows;
+        if (m_options.mTop.has_value())
+        {
+            std::sort(m_heap.begin(), m_heap.end(),
+                      [this](const Row& a, const Row& b) { return precedes(a.rank(), b.rank()); });
+            rows.reserve(m_heap.size() + m_failures.size());
+            for (const Row& row : m_heap)
+            {
+                rows.add(row.mName, row.mIsStdin, {}, row.mCounter);
+            }
+            m_heap.clear();
+        }
+        else
+        {
+            rows = std::move(m_kept);
+            std::vector<std::size_t> order(rows.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                return precedes({keyOf(rows.counter(a)), m_kept_indices[a], rows.name(a)},
+                                {keyOf(rows.counter(b)), m_kept_indices[b], rows.name(b)});
+            });
+            rows.reorder(std::move(order));
+        }
+
+        for (std::size_t i = 0; i < m_failures.size(); ++i)
+        {
+            rows.add(m_failures.name(i), m_failures.isStdin(i), m_failures.health(i),
+                     m_failures.counter(i));
+        }
+        return rows;
+    }
+
+} // namespace ccwc::algorithm
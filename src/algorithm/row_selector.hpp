@@ -0,0 +1,135 @@
+#ifndef CCWC_ALGORITHM_ROW_SELECTOR_HPP
+#define CCWC_ALGORITHM_ROW_SELECTOR_HPP
+
+#include "argument_parser/input_objects.hpp"
+#include "counter.hpp"
+#include "result_store.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief The count the rows are ordered by (`--sort-by`).
+     */
+    enum class SortKey : std::uint8_t
+    {
+        LINES,
+        WORDS,
+        CHARS,
+        BYTES,
+    };
+
+    /**
+     * @brief Parse a key name as accepted by `--sort-by=KEY`.
+     * @return The key, or std::nullopt if the name is unknown.
+     */
+    auto parseSortKey(std::string_view name) -> std::optional<SortKey>;
+
+    /**
+     * @brief Which rows are printed and in which order.
+     */
+    struct SelectionOptions
+    {
+        /**
+         * @brief Print only the N rows with the largest key (`--top=N`).
+         */
+        std::optional<std::size_t> mTop;
+
+        /**
+         * @brief Order the rows by this key, largest first; `--top` alone orders by bytes.
+         */
+        std::optional<SortKey> mSortBy;
+
+        /**
+         * @brief Drop the inputs with fewer lines, words, chars or bytes (`--min-lines=N`...);
+         * 0 keeps every input.
+         */
+        Counter mMinimum;
+    };
+
+    /**
+     * @brief Selects the rows of a report while the inputs are counted.
+     *
+     * Inputs below a minimum are dropped as soon as they are counted. With a top N only the N
+     * largest rows are kept, in a min-heap whose root is the row the next larger one evicts, so
+     * finding the 50 biggest files of millions costs 50 rows of memory and a comparison per file
+     * instead of a row per file and a sort. Failures are always kept to be reported.
+     */
+    class RowSelector
+    {
+      private:
+        /**
+         * @brief What the order of a row depends on.
+         */
+        struct Rank
+        {
+            std::size_t      mKey{0};
+            std::size_t      mIndex{0};
+            std::string_view mName;
+        };
+
+        /**
+         * @brief A row of the heap of a top N.
+         */
+        struct Row
+        {
+            std::size_t mKey{0};
+            std::size_t mIndex{0};
+            std::string mName;
+            bool        mIsStdin{false};
+            Counter     mCounter;
+
+            [[nodiscard]] auto rank() const -> Rank
+            {
+                return {mKey, mIndex, mName};
+            }
+        };
+
+        SelectionOptions         m_options;
+        bool                     m_by_path{false};
+        std::vector<Row>         m_heap;
+        ResultStore              m_kept;
+        std::vector<std::size_t> m_kept_indices;
+        ResultStore              m_failures;
+
+        /**
+         * @brief The key of a counter, 0 if the rows are not sorted.
+         */
+        [[nodiscard]] auto keyOf(const Counter& counter) const -> std::size_t;
+
+        /**
+         * @brief Whether a row ranked `a` is printed before one ranked `b`.
+         */
+        [[nodiscard]] auto precedes(const Rank& a, const Rank& b) const -> bool;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param options Which rows are kept.
+         * @param byPath Order rows of equal key by path rather than by the position they were
+         * counted at, which a parallel walk does not keep from one run to the next.
+         */
+        RowSelector(SelectionOptions options, bool byPath);
+
+        /**
+         * @brief Offer a counted input; a CountedCallback.
+         */
+        auto add(std::size_t index, const ccwc::argument_parser::InputDataObject& input,
+                 const Counter& counter) -> void;
+
+        /**
+         * @brief The selected rows in the order they are printed, followed by the failures.
+         */
+        [[nodiscard]] auto finish() -> ResultStore;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_ROW_SELECTOR_HPP
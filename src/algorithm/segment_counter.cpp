@@ -0,0 +1,120 @@
+#include "segment_counter.hpp"
+
+#include <cctype>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr unsigned char UTF8_CONT_MASK  = 0xC0; // 1100 0000
+        constexpr unsigned char UTF8_CONT_VALUE = 0x80; // 1000 0000
+        constexpr unsigned char UTF8_LEAD_2     = 0xC0; // 110x xxxx
+        constexpr unsigned char UTF8_LEAD_3     = 0xE0; // 1110 xxxx
+        constexpr unsigned char UTF8_LEAD_4     = 0xF0; // 1111 0xxx
+        constexpr unsigned char UTF8_MASK_3     = 0xE0;
+        constexpr unsigned char UTF8_MASK_4     = 0xF0;
+        constexpr unsigned char UTF8_MASK_5     = 0xF8;
+        constexpr std::size_t   UTF8_MAX_LENGTH = 4;
+
+        auto isContinuation(unsigned char byte) -> bool
+        {
+            return (byte & UTF8_CONT_MASK) == UTF8_CONT_VALUE;
+        }
+
+        auto sequenceLength(unsigned char lead) -> std::size_t
+        {
+            if ((lead & UTF8_MASK_3) == UTF8_LEAD_2)
+            {
+                return 2;
+            }
+            if ((lead & UTF8_MASK_4) == UTF8_LEAD_3)
+            {
+                return 3;
+            }
+            if ((lead & UTF8_MASK_5) == UTF8_LEAD_4)
+            {
+                return 4;
+            }
+            return 1;
+        }
+
+        auto isWordByte(unsigned char byte) -> bool
+        {
+            return std::isspace(byte) == 0;
+        }
+    } // namespace detail
+
+    auto SegmentCount::append(const SegmentCount& next) -> SegmentCount&
+    {
+        if (next.mEmpty)
+        {
+            return *this;
+        }
+        if (mEmpty)
+        {
+            *this = next;
+            return *this;
+        }
+
+        mCounter += next.mCounter;
+        if (detail::isWordByte(mLast) && detail::isWordByte(next.mFirst))
+        {
+            // The word continues across the border and was counted by both pieces.
+            mCounter.words--;
+        }
+        mLast = next.mLast;
+        return *this;
+    }
+
+    auto countSegment(std::span<const unsigned char> bytes, CounterStateMachine& stateMachine)
+        -> SegmentCount
+    {
+        SegmentCount segment;
+        if (bytes.empty())
+        {
+            return segment;
+        }
+
+        stateMachine.reset();
+        for (unsigned char byte : bytes)
+        {
+            stateMachine.updateState(byte);
+            stateMachine.updateCounter(segment.mCounter);
+        }
+        stateMachine.finalize(segment.mCounter);
+        stateMachine.reset();
+
+        segment.mFirst = bytes.front();
+        segment.mLast  = bytes.back();
+        segment.mEmpty = false;
+        return segment;
+    }
+
+    auto leadingUtf8Continuation(std::span<const unsigned char> bytes) -> std::size_t
+    {
+        std::size_t count{0};
+        while (count < bytes.size() && count < detail::UTF8_MAX_LENGTH - 1 &&
+               detail::isContinuation(bytes[count]))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    auto trailingIncompleteUtf8(std::span<const unsigned char> bytes) -> std::size_t
+    {
+        for (std::size_t back = 1; back <= detail::UTF8_MAX_LENGTH && back <= bytes.size(); ++back)
+        {
+            unsigned char byte = bytes[bytes.size() - back];
+            if (detail::isContinuation(byte))
+            {
+                continue;
+            }
+            // Found the lead byte of the last character; it is incomplete if it needs more bytes
+            // than are left in the piece.
+            return detail::sequenceLength(byte) > back ? back : 0;
+        }
+        return 0;
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,77 @@
+#ifndef CCWC_ALGORITHM_SEGMENT_COUNTER_HPP
+#define CCWC_ALGORITHM_SEGMENT_COUNTER_HPP
+
+#include "counter.hpp"
+#include "counter_state_machine.hpp"
+
+#include <cstddef>
+#include <span>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief Counts of an independent piece of an input, plus what is needed to merge it with
+     * its neighbours.
+     *
+     * Lines, bytes and characters simply add up across pieces. A word that straddles the border
+     * of two pieces is counted once in each, so the first and last byte are kept to detect and
+     * undo that double count when the pieces are merged.
+     */
+    struct SegmentCount
+    {
+        /**
+         * @brief The counts of the piece on its own.
+         */
+        Counter mCounter;
+
+        /**
+         * @brief The first byte of the piece (valid if the piece is not empty).
+         */
+        unsigned char mFirst{0};
+
+        /**
+         * @brief The last byte of the piece (valid if the piece is not empty).
+         */
+        unsigned char mLast{0};
+
+        /**
+         * @brief Whether the piece contained no bytes at all.
+         */
+        bool mEmpty{true};
+
+        /**
+         * @brief Append the counts of the piece that directly follows this one.
+         */
+        auto append(const SegmentCount& next) -> SegmentCount&;
+    };
+
+    /**
+     * @brief Count one piece of an input with the given state machine chain.
+     *
+     * The chain is reset before and after, so it can be reused for many pieces.
+     *
+     * @param bytes The bytes of the piece.
+     * @param stateMachine The chain to count with.
+     * @return The counts of the piece.
+     */
+    auto countSegment(std::span<const unsigned char> bytes, CounterStateMachine& stateMachine)
+        -> SegmentCount;
+
+    /**
+     * @brief Number of UTF-8 continuation bytes at the start of a piece.
+     *
+     * These belong to a character that started in the previous piece.
+     */
+    auto leadingUtf8Continuation(std::span<const unsigned char> bytes) -> std::size_t;
+
+    /**
+     * @brief Number of bytes at the end of a piece that form an incomplete UTF-8 character.
+     *
+     * These are completed by the continuation bytes at the start of the next piece.
+     */
+    auto trailingIncompleteUtf8(std::span<const unsigned char> bytes) -> std::size_t;
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_SEGMENT_COUNTER_HPP
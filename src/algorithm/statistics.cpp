@@ -0,0 +1,264 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <sys/resource.h>
+#include <time.h>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr double MEBIBYTE = 1024.0 * 1024.0;
+        constexpr double PERCENT  = 100.0;
+
+        /**
+         * @brief Below this share of its counting time on the CPU, the counting thread mostly
+         * waited; below this share of the run spent counting, the rest of the run dominated.
+         */
+        constexpr double BUSY_THRESHOLD = 0.5;
+
+        auto usageOf(int who, clockid_t clock) -> ResourceUsage
+        {
+            auto cpuTime = [](const timeval& time) {
+                return std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec);
+            };
+
+            ResourceUsage result;
+            timespec      cpu{};
+            if (::clock_gettime(clock, &cpu) == 0)
+            {
+                result.mCpu =
+                    std::chrono::seconds(cpu.tv_sec) + std::chrono::nanoseconds(cpu.tv_nsec);
+            }
+
+            struct rusage usage{};
+            if (::getrusage(who, &usage) != 0)
+            {
+                return result;
+            }
+            result.mUser        = cpuTime(usage.ru_utime);
+            result.mSystem      = cpuTime(usage.ru_stime);
+            result.mMinorFaults = static_cast<std::uint64_t>(usage.ru_minflt);
+            result.mMajorFaults = static_cast<std::uint64_t>(usage.ru_majflt);
+            return result;
+        }
+
+        /**
+         * @brief The usage an input is measured with: that of the process if its stream decodes
+         * or counts on threads of its own, whose CPU time the counting thread does not see.
+         */
+        auto usageFor(const UniversalInputStream* stream) -> ResourceUsage
+        {
+            return stream != nullptr && stream->countsOffThread() ? ResourceUsage::ofProcess()
+                                                                  : ResourceUsage::ofThread();
+        }
+
+        auto milliseconds(std::chrono::nanoseconds duration) -> double
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+
+        auto mebibytesPerSecond(std::uint64_t bytes, std::chrono::nanoseconds duration) -> double
+        {
+            double seconds = std::chrono::duration<double>(duration).count();
+            return seconds > 0 ? static_cast<double>(bytes) / seconds / MEBIBYTE : 0;
+        }
+
+        auto appendHistogram(std::ostringstream&                       line,
+                             const std::map<std::string, std::size_t>& histogram) -> void
+        {
+            const char* separator = "";
+            for (const auto& [name, count] : histogram)
+            {
+                line << separator << name << ' ' << count;
+                separator = ", ";
+            }
+        }
+    } // namespace detail
+
+    auto ResourceUsage::ofThread() -> ResourceUsage
+    {
+#if defined(RUSAGE_THREAD)
+        return detail::usageOf(RUSAGE_THREAD, CLOCK_THREAD_CPUTIME_ID);
+#else
+        return detail::usageOf(RUSAGE_SELF, CLOCK_THREAD_CPUTIME_ID);
+#endif
+    }
+
+    auto ResourceUsage::ofProcess() -> ResourceUsage
+    {
+        return detail::usageOf(RUSAGE_SELF, CLOCK_PROCESS_CPUTIME_ID);
+    }
+
+    auto ResourceUsage::operator-=(const ResourceUsage& other) -> ResourceUsage&
+    {
+        mCpu -= other.mCpu;
+        mUser -= other.mUser;
+        mSystem -= other.mSystem;
+        mMinorFaults -= other.mMinorFaults;
+        mMajorFaults -= other.mMajorFaults;
+        return *this;
+    }
+
+    auto ResourceUsage::operator+=(const ResourceUsage& other) -> ResourceUsage&
+    {
+        mCpu += other.mCpu;
+        mUser += other.mUser;
+        mSystem += other.mSystem;
+        mMinorFaults += other.mMinorFaults;
+        mMajorFaults += other.mMajorFaults;
+        return *this;
+    }
+
+    StatisticsRecorder::StatisticsRecorder(bool printInputs, bool perfCounters)
+        : m_start(std::chrono::steady_clock::now()), m_process_start(ResourceUsage::ofProcess()),
+          m_print_inputs(printInputs)
+    {
+        if (perfCounters)
+        {
+            m_perf.emplace();
+        }
+    }
+
+    auto StatisticsRecorder::start(const UniversalInputStream* stream) const -> InputMeasurement
+    {
+        return {std::chrono::steady_clock::now(), detail::usageFor(stream),
+                stream != nullptr ? stream->ioCalls() : 0,
+                m_perf.has_value() ? m_perf->sample() : PerfSample{}};
+    }
+
+    auto StatisticsRecorder::finish(const std::string& name, const InputMeasurement& started,
+                                    const UniversalInputStream* stream, const Counter& counter)
+        -> void
+    {
+        if (stream == nullptr)
+        {
+            // Answered from the result cache: nothing was read, so there is no rate to report.
+            std::ostringstream line;
+            line << "ccwc: stats: " << name << ": " << counter.bytes << " bytes, cache hit\n";
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_print_inputs)
+            {
+                std::fputs(line.str().c_str(), stderr);
+            }
+            m_cache_hits += 1;
+            m_cached_bytes += counter.bytes;
+            m_bytes += counter.bytes;
+            return;
+        }
+
+        auto          wall  = std::chrono::steady_clock::now() - started.mStart;
+        ResourceUsage usage = detail::usageFor(stream);
+        usage -= started.mUsage;
+
+        std::uint64_t    ioCalls = stream->ioCalls() - started.mIoCalls;
+        std::string_view backend = stream->backend();
+        std::string_view kernel  = stream->kernel();
+
+        std::ostringstream line;
+        line.precision(3);
+        line << std::fixed << "ccwc: stats: " << name << ": " << counter.bytes << " bytes in "
+             << detail::milliseconds(wall) << "ms ("
+             << detail::mebibytesPerSecond(counter.bytes, wall) << " MiB/s), " << backend << " x"
+             << ioCalls << ", " << kernel << ", CPU "
+             << detail::milliseconds(usage.mCpu) << "ms, faults "
+             << usage.mMinorFaults << " minor " << usage.mMajorFaults << " major\n";
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_perf.has_value() && stream->countsOffThread())
+        {
+            std::string stage = "count (" + std::string(kernel) + ", " + std::string(backend) + ")";
+            m_perf->addOffThread(stage, counter.bytes);
+        }
+        else if (m_perf.has_value())
+        {
+            m_perf->addCount(std::string(kernel), started.mPerf, counter.bytes);
+        }
+        if (m_print_inputs)
+        {
+            std::fputs(line.str().c_str(), stderr);
+        }
+        m_counting += usage;
+        m_counting_time += wall;
+        m_inputs += 1;
+        m_bytes += counter.bytes;
+        m_io_calls += ioCalls;
+        m_backends[std::string(backend)] += 1;
+        m_kernels[std::string(kernel)] += 1;
+    }
+
+    auto StatisticsRecorder::summary() const -> std::string
+    {
+        auto          wall    = std::chrono::steady_clock::now() - m_start;
+        ResourceUsage process = ResourceUsage::ofProcess();
+        process -= m_process_start;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto   otherCpu  = std::max(process.mCpu - m_counting.mCpu, std::chrono::nanoseconds(0));
+        double wallTime  = detail::milliseconds(wall);
+        double countTime = detail::milliseconds(m_counting_time);
+        double cores     = wallTime > 0 ? detail::milliseconds(process.mCpu) / wallTime : 0;
+        double busy      = countTime > 0 ? detail::milliseconds(m_counting.mCpu) / countTime : 0;
+
+        std::ostringstream lines;
+        lines.precision(3);
+        std::uint64_t readBytes = m_bytes - m_cached_bytes;
+        lines << std::fixed << "ccwc: stats: total: " << m_inputs << " inputs read, " << readBytes
+              << " bytes in " << wallTime << "ms ("
+              << detail::mebibytesPerSecond(readBytes, wall) << " MiB/s), " << m_io_calls
+              << " read calls or mapped windows\n";
+        if (m_cache_hits > 0)
+        {
+            lines << "ccwc: stats: cache: " << m_cache_hits << " hits, " << m_cached_bytes
+                  << " bytes not read\n";
+        }
+        lines << "ccwc: stats: faults: " << process.mMinorFaults << " minor, "
+              << process.mMajorFaults << " major (" << m_counting.mMinorFaults << " minor, "
+              << m_counting.mMajorFaults << " major while counting)\n";
+        lines << "ccwc: stats: CPU: " << detail::milliseconds(process.mUser) << "ms user, "
+              << detail::milliseconds(process.mSystem) << "ms system, " << cores
+              << " cores busy; counting was on the CPU " << busy * detail::PERCENT << "% of the "
+              << countTime << "ms it took, the rest of the run used "
+              << detail::milliseconds(otherCpu) << "ms\n";
+        lines << "ccwc: stats: backends: ";
+        detail::appendHistogram(lines, m_backends);
+        lines << "; kernels: ";
+        detail::appendHistogram(lines, m_kernels);
+        lines << '\n';
+
+        lines << "ccwc: stats: looks ";
+        if (countTime < detail::BUSY_THRESHOLD * wallTime)
+        {
+            lines << "bound outside the count: opening, walking or printing took most of the time";
+        }
+        else if (busy >= detail::BUSY_THRESHOLD)
+        {
+            lines << "CPU-bound";
+        }
+        else if (m_counting.mMajorFaults > 0)
+        {
+            lines << "fault-bound: the counting thread waited on major page faults";
+        }
+        else
+        {
+            lines << "I/O-bound: the counting thread waited on reads";
+        }
+        lines << '\n';
+        return lines.str();
+    }
+
+    auto StatisticsRecorder::perfCounters() -> PerfCounters*
+    {
+        return m_perf.has_value() ? &m_perf.value() : nullptr;
+    }
+
+    auto StatisticsRecorder::bytes() const -> std::uint64_t
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytes;
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,146 @@
+#ifndef CCWC_ALGORITHM_STATISTICS_HPP
+#define CCWC_ALGORITHM_STATISTICS_HPP
+
+#include "counter.hpp"
+#include "perf_counters.hpp"
+#include "universal_input_stream.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief CPU time and page faults.
+     *
+     * getrusage() splits the CPU time into user and system time but only in scheduler ticks,
+     * too coarse for an input counted in microseconds, so the CPU time used to compare inputs
+     * comes from the CPU time clocks.
+     */
+    struct ResourceUsage
+    {
+        std::chrono::nanoseconds  mCpu{0};
+        std::chrono::microseconds mUser{0};
+        std::chrono::microseconds mSystem{0};
+        std::uint64_t             mMinorFaults{0};
+        std::uint64_t             mMajorFaults{0};
+
+        /**
+         * @brief The usage of the calling thread; of the process where the system does not
+         * account threads apart.
+         */
+        static auto ofThread() -> ResourceUsage;
+
+        /**
+         * @brief The usage of the whole process, every thread included.
+         */
+        static auto ofProcess() -> ResourceUsage;
+
+        /**
+         * @brief Operator to subtract an earlier usage.
+         */
+        auto operator-=(const ResourceUsage& other) -> ResourceUsage&;
+
+        /**
+         * @brief Operator to add the usage of another input.
+         */
+        auto operator+=(const ResourceUsage& other) -> ResourceUsage&;
+    };
+
+    /**
+     * @brief Where an input stood when it started being counted.
+     */
+    struct InputMeasurement
+    {
+        std::chrono::steady_clock::time_point mStart;
+        ResourceUsage                         mUsage;
+        std::uint64_t                         mIoCalls{0};
+        PerfSample                            mPerf;
+    };
+
+    /**
+     * @brief Measures each counted input and the whole run for `--stats`.
+     *
+     * Each input is measured on the counting thread: its wall time, the read calls or mapped
+     * windows of its stream, and the CPU time and page faults of the thread while it was
+     * counted, or of the whole process if the stream decodes on threads of its own. Its line is
+     * printed on stderr as soon as it is counted, so a slow input shows up while the run goes
+     * on. Inputs answered from the result cache are listed as hits and kept out of the rates
+     * and CPU times, since nothing of them was read. The summary compares that CPU time with
+     * the time spent counting, and with the CPU time of the whole process, which tells whether
+     * the run waited on the disk, on page faults or on the CPU.
+     *
+     * With `--perf-counters` the counting thread also reads its hardware counters around each
+     * input, which books the read and count stages of its kernel; the lines of the inputs and
+     * the summary are only printed with `--stats`.
+     */
+    class StatisticsRecorder
+    {
+      private:
+        std::chrono::steady_clock::time_point m_start;
+        ResourceUsage                         m_process_start;
+        ResourceUsage                         m_counting;
+        std::chrono::nanoseconds              m_counting_time{0};
+        std::uint64_t                         m_inputs{0};
+        std::uint64_t                         m_bytes{0};
+        std::uint64_t                         m_io_calls{0};
+        std::uint64_t                         m_cache_hits{0};
+        std::uint64_t                         m_cached_bytes{0};
+        std::map<std::string, std::size_t>    m_backends;
+        std::map<std::string, std::size_t>    m_kernels;
+        bool                                  m_print_inputs{true};
+        std::optional<PerfCounters>           m_perf;
+        mutable std::mutex                    m_mutex;
+
+      public:
+        /**
+         * @brief Constructor: the run starts now.
+         * @param printInputs Print a line per input as it is counted (`--stats`).
+         * @param perfCounters Open the hardware counters of the calling thread, the one the
+         * inputs are counted on (`--perf-counters`).
+         */
+        StatisticsRecorder(bool printInputs, bool perfCounters);
+
+        /**
+         * @brief An input starts being counted on the calling thread.
+         * @param stream Its stream, nullptr if its counter is not read from one (cached).
+         */
+        [[nodiscard]] auto start(const UniversalInputStream* stream) const -> InputMeasurement;
+
+        /**
+         * @brief An input was counted on the calling thread; prints its line.
+         * @param name The name of the input.
+         * @param started What start() returned for it.
+         * @param stream Its stream, nullptr if it was answered from the result cache.
+         * @param counter Its counter.
+         */
+        auto finish(const std::string& name, const InputMeasurement& started,
+                    const UniversalInputStream* stream, const Counter& counter) -> void;
+
+        /**
+         * @brief The lines describing the whole run.
+         */
+        [[nodiscard]] auto summary() const -> std::string;
+
+        /**
+         * @brief The hardware counters, nullptr without `--perf-counters`; the other stages are
+         * booked in them directly.
+         */
+        [[nodiscard]] auto perfCounters() -> PerfCounters*;
+
+        /**
+         * @brief The bytes counted so far.
+         */
+        [[nodiscard]] auto bytes() const -> std::uint64_t;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_STATISTICS_HPP
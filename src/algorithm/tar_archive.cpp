@@ -0,0 +1,401 @@
+#include "tar_archive.hpp"
+
+#include "exception/exception.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <numeric>
+#include <optional>
+#include <string_view>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        constexpr std::size_t TAR_BLOCK_SIZE = 512;
+
+        constexpr std::size_t NAME_OFFSET     = 0;
+        constexpr std::size_t NAME_LENGTH     = 100;
+        constexpr std::size_t SIZE_OFFSET     = 124;
+        constexpr std::size_t SIZE_LENGTH     = 12;
+        constexpr std::size_t CHKSUM_OFFSET   = 148;
+        constexpr std::size_t CHKSUM_LENGTH   = 8;
+        constexpr std::size_t TYPEFLAG_OFFSET = 156;
+        constexpr std::size_t MAGIC_OFFSET    = 257;
+        constexpr std::size_t MAGIC_LENGTH    = 6;
+        constexpr std::size_t PREFIX_OFFSET   = 345;
+        constexpr std::size_t PREFIX_LENGTH   = 155;
+
+        constexpr char TYPE_REGULAR      = '0';
+        constexpr char TYPE_REGULAR_OLD  = '\0';
+        constexpr char TYPE_CONTIGUOUS   = '7';
+        constexpr char TYPE_GNU_LONGNAME = 'L';
+        constexpr char TYPE_PAX_HEADER   = 'x';
+
+        constexpr unsigned char BASE256_FLAG = 0x80;
+        constexpr unsigned char BASE256_MASK = 0x7F;
+        constexpr unsigned      OCTAL_BASE   = 8;
+        constexpr unsigned      BYTE_BITS    = 8;
+
+        using TarHeader = std::array<unsigned char, TAR_BLOCK_SIZE>;
+
+        /**
+         * @brief Reads the data of one archive member.
+         */
+        class TarMemberInputStream : public UniversalInputStream
+        {
+          private:
+            std::string           m_name;
+            UniversalInputStream* m_archive;
+            std::uint64_t         m_remaining;
+
+          public:
+            TarMemberInputStream(std::string name, UniversalInputStream& archive,
+                                 std::uint64_t size)
+                : m_name(std::move(name)), m_archive(&archive), m_remaining(size)
+            {
+            }
+
+            ~TarMemberInputStream() override = default;
+
+            TarMemberInputStream(const TarMemberInputStream&)                    = delete;
+            auto operator=(const TarMemberInputStream&) -> TarMemberInputStream& = delete;
+            TarMemberInputStream(TarMemberInputStream&&)                         = delete;
+            auto operator=(TarMemberInputStream&&) -> TarMemberInputStream&      = delete;
+
+            [[nodiscard]] auto name() const -> std::string override
+            {
+                return m_name;
+            }
+
+            [[nodiscard]] auto isStdin() const -> bool override
+            {
+                return false;
+            }
+
+            auto nextByte() -> std::optional<unsigned char> override
+            {
+                if (m_remaining == 0)
+                {
+                    return std::nullopt;
+                }
+                auto byte = m_archive->nextByte();
+                if (!byte.has_value())
+                {
+                    m_remaining = 0;
+                    throw ccwc::exception::FileOperationException(
+                        m_name + ": unexpected end of archive");
+                }
+                --m_remaining;
+                return byte;
+            }
+
+            auto reset() -> bool override
+            {
+                return false; // the archive is read sequentially
+            }
+
+            [[nodiscard]] auto good() const -> bool override
+            {
+                return m_remaining > 0;
+            }
+
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return m_archive->backend();
+            }
+
+            [[nodiscard]] auto countsOffThread() const -> bool override
+            {
+                return m_archive->countsOffThread();
+            }
+
+            /**
+             * @brief The calls of the whole archive so far.
+             */
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return m_archive->ioCalls();
+            }
+
+            /**
+             * @brief Number of bytes of the member that were not read yet.
+             */
+            [[nodiscard]] auto remaining() const noexcept -> std::uint64_t
+            {
+                return m_remaining;
+            }
+        };
+
+        /**
+         * @brief Read one 512-byte block.
+         * @return The number of bytes read; less than a block means the archive ended.
+         */
+        auto readBlock(UniversalInputStream& archive, TarHeader& block) -> std::size_t
+        {
+            std::size_t count{0};
+            while (count < block.size())
+            {
+                auto byte = archive.nextByte();
+                if (!byte.has_value())
+                {
+                    break;
+                }
+                block[count++] = byte.value();
+            }
+            return count;
+        }
+
+        /**
+         * @brief Read `size` bytes of member data into a string.
+         */
+        auto readData(UniversalInputStream& archive, std::uint64_t size) -> std::string
+        {
+            std::string data;
+            for (std::uint64_t i = 0; i < size; ++i)
+            {
+                auto byte = archive.nextByte();
+                if (!byte.has_value())
+                {
+                    throw ccwc::exception::FileOperationException("unexpected end of archive");
+                }
+                data.push_back(static_cast<char>(byte.value()));
+            }
+            return data;
+        }
+
+        /**
+         * @brief Get a NUL-terminated header field as a string.
+         */
+        auto field(const TarHeader& header, std::size_t offset, std::size_t length) -> std::string
+        {
+            auto begin = header.begin() + static_cast<std::ptrdiff_t>(offset);
+            auto end   = begin + static_cast<std::ptrdiff_t>(length);
+            return {begin, std::find(begin, end, '\0')};
+        }
+
+        /**
+         * @brief Parse a numeric header field (octal, or GNU base-256 for large values).
+         */
+        auto parseNumber(const TarHeader& header, std::size_t offset, std::size_t length)
+            -> std::uint64_t
+        {
+            std::uint64_t value{0};
+            if ((header[offset] & BASE256_FLAG) != 0)
+            {
+                value = header[offset] & BASE256_MASK;
+                for (std::size_t i = 1; i < length; ++i)
+                {
+                    value = (value << BYTE_BITS) | header[offset + i];
+                }
+                return value;
+            }
+
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                unsigned char digit = header[offset + i];
+                if (digit >= '0' && digit <= '7')
+                {
+                    value = value * OCTAL_BASE + (digit - '0');
+                }
+                else if (digit != ' ' || value != 0)
+                {
+                    break; // NUL or space terminator
+                }
+            }
+            return value;
+        }
+
+        /**
+         * @brief Check the header checksum, which is computed with the field set to spaces.
+         */
+        auto checksumMatches(const TarHeader& header) -> bool
+        {
+            unsigned sum = std::accumulate(header.begin(), header.end(), 0U);
+            for (std::size_t i = 0; i < CHKSUM_LENGTH; ++i)
+            {
+                sum = sum - header[CHKSUM_OFFSET + i] + ' ';
+            }
+            return sum == parseNumber(header, CHKSUM_OFFSET, CHKSUM_LENGTH);
+        }
+
+        /**
+         * @brief Path and size overrides from a pax extended header.
+         */
+        struct PaxOverrides
+        {
+            std::optional<std::string>   mPath;
+            std::optional<std::uint64_t> mSize;
+        };
+
+        /**
+         * @brief Parse the "<length> <key>=<value>\n" records of a pax extended header.
+         * @return False if a record or a size is malformed.
+         */
+        auto parsePax(std::string_view records, PaxOverrides& overrides) -> bool
+        {
+            while (!records.empty())
+            {
+                std::size_t length{0};
+                auto [end, error] =
+                    std::from_chars(records.data(), records.data() + records.size(), length);
+                auto pos = static_cast<std::size_t>(end - records.data());
+                if (error != std::errc() || length > records.size() || pos + 2 > length ||
+                    records[pos] != ' ' || records[length - 1] != '\n')
+                {
+                    return false;
+                }
+
+                std::string_view record = records.substr(pos + 1, length - pos - 2);
+                std::size_t      equals = record.find('=');
+                if (equals != std::string_view::npos)
+                {
+                    std::string_view key   = record.substr(0, equals);
+                    std::string_view value = record.substr(equals + 1);
+                    if (key == "path")
+                    {
+                        overrides.mPath = std::string(value);
+                    }
+                    else if (key == "size")
+                    {
+                        std::uint64_t size{0};
+                        auto [sizeEnd, sizeError] =
+                            std::from_chars(value.data(), value.data() + value.size(), size);
+                        if (value.empty() || sizeError != std::errc() ||
+                            sizeEnd != value.data() + value.size())
+                        {
+                            return false;
+                        }
+                        overrides.mSize = size;
+                    }
+                }
+                records.remove_prefix(length);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Number of padding bytes after `size` bytes of data.
+         */
+        auto paddingFor(std::uint64_t size) -> std::uint64_t
+        {
+            return (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+        }
+    } // namespace detail
+
+    TarArchiveReader::TarArchiveReader(UniversalInputStream& archive)
+        : m_archive(archive), m_prefix((archive.isStdin() ? "-" : archive.name()) + ":")
+    {
+    }
+
+    auto TarArchiveReader::skip(std::uint64_t count) -> void
+    {
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            if (!m_archive.nextByte().has_value())
+            {
+                throw ccwc::exception::FileOperationException(m_archive.name() +
+                                                              ": unexpected end of archive");
+            }
+        }
+    }
+
+    auto TarArchiveReader::nextMember() -> std::unique_ptr<UniversalInputStream>
+    {
+        if (m_current != nullptr)
+        {
+            skip(m_current->remaining() + m_padding);
+            m_current = nullptr;
+            m_padding = 0;
+        }
+
+        std::optional<std::string> longName;
+        detail::PaxOverrides       pax;
+        detail::TarHeader          header{};
+
+        while (true)
+        {
+            std::size_t got = detail::readBlock(m_archive, header);
+            if (got == 0)
+            {
+                return nullptr;
+            }
+            if (got < header.size())
+            {
+                throw ccwc::exception::FileOperationException(m_archive.name() +
+                                                              ": unexpected end of archive");
+            }
+            if (std::all_of(header.begin(), header.end(), [](unsigned char c) { return c == 0; }))
+            {
+                return nullptr; // end-of-archive marker
+            }
+            if (!detail::checksumMatches(header))
+            {
+                throw ccwc::exception::FileOperationException(
+                    m_archive.name() + ": not a tar archive or corrupt header");
+            }
+
+            std::uint64_t size = pax.mSize.value_or(
+                detail::parseNumber(header, detail::SIZE_OFFSET, detail::SIZE_LENGTH));
+            std::uint64_t padding = detail::paddingFor(size);
+            auto          type    = static_cast<char>(header[detail::TYPEFLAG_OFFSET]);
+
+            if (type == detail::TYPE_GNU_LONGNAME)
+            {
+                std::string name = detail::readData(m_archive, size);
+                longName         = name.substr(0, name.find('\0'));
+                skip(padding);
+                continue;
+            }
+            if (type == detail::TYPE_PAX_HEADER)
+            {
+                if (!detail::parsePax(detail::readData(m_archive, size), pax))
+                {
+                    throw ccwc::exception::FileOperationException(m_archive.name() +
+                                                                  ": malformed pax header");
+                }
+                skip(padding);
+                continue;
+            }
+            if (type != detail::TYPE_REGULAR && type != detail::TYPE_REGULAR_OLD &&
+                type != detail::TYPE_CONTIGUOUS)
+            {
+                // Directories, links, devices and global headers carry no countable content.
+                skip(size + padding);
+                longName.reset();
+                pax = {};
+                continue;
+            }
+
+            std::string path;
+            if (pax.mPath.has_value())
+            {
+                path = pax.mPath.value();
+            }
+            else if (longName.has_value())
+            {
+                path = longName.value();
+            }
+            else
+            {
+                // Only POSIX ustar headers have a prefix field; old GNU headers store times there.
+                std::string name =
+                    detail::field(header, detail::NAME_OFFSET, detail::NAME_LENGTH);
+                std::string prefix =
+                    detail::field(header, detail::PREFIX_OFFSET, detail::PREFIX_LENGTH);
+                bool isUstar =
+                    detail::field(header, detail::MAGIC_OFFSET, detail::MAGIC_LENGTH) == "ustar";
+                path = (isUstar && !prefix.empty()) ? prefix + "/" + name : name;
+            }
+
+            auto member =
+                std::make_unique<detail::TarMemberInputStream>(m_prefix + path, m_archive, size);
+            m_current = member.get();
+            m_padding = padding;
+            return member;
+        }
+    }
+
+} // namespace ccwc::algorithm
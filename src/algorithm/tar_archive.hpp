@@ -0,0 +1,76 @@
+#ifndef CCWC_ALGORITHM_TAR_ARCHIVE_HPP
+#define CCWC_ALGORITHM_TAR_ARCHIVE_HPP
+
+#include "universal_input_stream.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ccwc::algorithm
+{
+
+    namespace detail
+    {
+        class TarMemberInputStream;
+    } // namespace detail
+
+    /**
+     * @brief Walks the members of a tar archive without extracting it.
+     *
+     * The archive is read strictly sequentially from any UniversalInputStream, so it can come
+     * from a pipe or a decompressing stream. Headers in the ustar, GNU (long names) and pax
+     * (path/size records) dialects are understood; members that are not regular files are
+     * skipped.
+     */
+    class TarArchiveReader
+    {
+      private:
+        /**
+         * @brief The archive being walked.
+         */
+        UniversalInputStream& m_archive;
+
+        /**
+         * @brief Name the members are prefixed with (`archive.tar:`).
+         */
+        std::string m_prefix;
+
+        /**
+         * @brief The member returned last, whose unread data is skipped by the next call.
+         */
+        detail::TarMemberInputStream* m_current{nullptr};
+
+        /**
+         * @brief Padding that follows the data of the current member.
+         */
+        std::uint64_t m_padding{0};
+
+        /**
+         * @brief Discard `count` bytes of the archive.
+         */
+        auto skip(std::uint64_t count) -> void;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param archive The archive to read; it must outlive the reader and its members.
+         */
+        explicit TarArchiveReader(UniversalInputStream& archive);
+
+        /**
+         * @brief Advance to the next regular file in the archive.
+         *
+         * The returned stream reads the data of the member and is named
+         * `archive.tar:path/in/archive`. Data the caller did not read is skipped on the next
+         * call.
+         *
+         * @return The member, or nullptr at the end of the archive.
+         * @throws ccwc::exception::FileOperationException if the archive is malformed.
+         */
+        auto nextMember() -> std::unique_ptr<UniversalInputStream>;
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_TAR_ARCHIVE_HPP
@@ -0,0 +1,248 @@
+#include "trace.hpp"
+
+#include "exception/exception.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace ccwc::algorithm
+{
+    namespace detail
+    {
+        /**
+         * @brief Spans a thread keeps, about 5MB; a walk of millions of files keeps its last
+         * ones.
+         */
+        constexpr std::size_t MAX_EVENTS_PER_THREAD = 1U << 16U;
+
+        /**
+         * @brief Spans a thread reserves room for when it records its first; most threads only
+         * record a few.
+         */
+        constexpr std::size_t INITIAL_EVENTS_PER_THREAD = 256;
+
+        constexpr double NANOSECONDS_PER_MICROSECOND = 1000.0;
+
+        /**
+         * @brief The spans of one thread. Only that thread writes to it; it outlives the thread
+         * so that the trace can be written once every thread is joined.
+         */
+        struct ThreadBuffer
+        {
+            std::size_t             mThread{0};
+            const char*             mName{nullptr};
+            std::vector<TraceEvent> mEvents;
+            std::uint64_t           mRecorded{0};
+
+            auto record(const TraceEvent& event) -> void
+            {
+                if (mEvents.size() < MAX_EVENTS_PER_THREAD)
+                {
+                    mEvents.push_back(event);
+                }
+                else
+                {
+                    mEvents[mRecorded % MAX_EVENTS_PER_THREAD] = event;
+                }
+                ++mRecorded;
+            }
+        };
+
+        std::atomic<bool>                          tracing{false};
+        std::chrono::steady_clock::time_point      traceStart;
+        std::mutex                                 buffersMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        thread_local ThreadBuffer*                 threadBuffer = nullptr;
+
+        auto now() -> std::uint64_t
+        {
+            return static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - traceStart)
+                    .count());
+        }
+
+        /**
+         * @brief The buffer of the calling thread, registered the first time it records; the
+         * only lock a thread takes.
+         */
+        auto bufferOfThisThread() -> ThreadBuffer&
+        {
+            if (threadBuffer == nullptr)
+            {
+                auto buffer = std::make_unique<ThreadBuffer>();
+                buffer->mEvents.reserve(INITIAL_EVENTS_PER_THREAD);
+                std::lock_guard lock(buffersMutex);
+                buffer->mThread = buffers.size() + 1;
+                threadBuffer    = buffers.emplace_back(std::move(buffer)).get();
+            }
+            return *threadBuffer;
+        }
+
+        auto copyDetail(std::string_view detail, std::array<char, TraceEvent::DETAIL_SIZE + 1>& to)
+            -> void
+        {
+            if (detail.size() > TraceEvent::DETAIL_SIZE)
+            {
+                detail.remove_prefix(detail.size() - TraceEvent::DETAIL_SIZE);
+            }
+            std::copy(detail.begin(), detail.end(), to.begin());
+            to.at(detail.size()) = '\0';
+        }
+
+        auto appendJsonString(std::string& out, std::string_view text) -> void
+        {
+            out += '"';
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (static_cast<unsigned char>(c) < ' ')
+                {
+                    std::array<char, sizeof("\\u0000")> escaped{};
+                    std::snprintf(escaped.data(), escaped.size(), "\\u%04x",
+                                  static_cast<unsigned>(c));
+                    out += escaped.data();
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+
+        auto appendMicroseconds(std::string& out, std::uint64_t nanoseconds) -> void
+        {
+            std::array<char, 32> number{};
+            std::snprintf(number.data(), number.size(), "%.3f",
+                          static_cast<double>(nanoseconds) / NANOSECONDS_PER_MICROSECOND);
+            out += number.data();
+        }
+
+        auto appendThreadName(std::string& out, const ThreadBuffer& buffer, std::string_view pid)
+            -> void
+        {
+            std::string name = buffer.mName != nullptr
+                                   ? std::string(buffer.mName)
+                                   : "thread " + std::to_string(buffer.mThread);
+            if (buffer.mRecorded > buffer.mEvents.size())
+            {
+                name += " (" + std::to_string(buffer.mRecorded - buffer.mEvents.size()) +
+                        " earlier spans dropped)";
+            }
+            out += R"({"name":"thread_name","ph":"M","pid":)";
+            out += pid;
+            out += R"(,"tid":)" + std::to_string(buffer.mThread) + R"(,"args":{"name":)";
+            appendJsonString(out, name);
+            out += "}}";
+        }
+
+        auto appendEvent(std::string& out, const TraceEvent& event, std::size_t thread,
+                         std::string_view pid) -> void
+        {
+            out += R"({"name":)";
+            appendJsonString(out, event.mName);
+            out += R"(,"cat":"ccwc","ph":"X","pid":)";
+            out += pid;
+            out += R"(,"tid":)" + std::to_string(thread) + R"(,"ts":)";
+            appendMicroseconds(out, event.mStart);
+            out += R"(,"dur":)";
+            appendMicroseconds(out, event.mDuration);
+            out += R"(,"args":{"bytes":)" + std::to_string(event.mBytes);
+            if (event.mDetail.front() != '\0')
+            {
+                out += R"(,"input":)";
+                appendJsonString(out, event.mDetail.data());
+            }
+            out += "}}";
+        }
+    } // namespace detail
+
+    auto enableTracing() -> void
+    {
+        detail::traceStart = std::chrono::steady_clock::now();
+        detail::tracing.store(true, std::memory_order_relaxed);
+        nameTracedThread("main");
+    }
+
+    auto isTracing() -> bool
+    {
+        return detail::tracing.load(std::memory_order_relaxed);
+    }
+
+    auto nameTracedThread(const char* name) -> void
+    {
+        if (isTracing())
+        {
+            detail::bufferOfThisThread().mName = name;
+        }
+    }
+
+    auto writeTrace(const std::string& path) -> void
+    {
+        std::string pid = std::to_string(::getpid());
+        std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+        const char* separator = "\n";
+
+        std::lock_guard lock(detail::buffersMutex);
+        for (const auto& buffer : detail::buffers)
+        {
+            out += separator;
+            detail::appendThreadName(out, *buffer, pid);
+            separator = ",\n";
+            for (const TraceEvent& event : buffer->mEvents)
+            {
+                out += separator;
+                detail::appendEvent(out, event, buffer->mThread, pid);
+            }
+        }
+        out += "\n]}\n";
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size())))
+        {
+            throw ccwc::exception::FileOperationException(path + ": " + std::strerror(errno));
+        }
+    }
+
+    TraceSpan::TraceSpan(const char* name, std::string_view detail) : m_active(isTracing())
+    {
+        if (m_active)
+        {
+            m_event.mName = name;
+            detail::copyDetail(detail, m_event.mDetail);
+            m_event.mStart = detail::now();
+        }
+    }
+
+    TraceSpan::~TraceSpan()
+    {
+        if (m_active)
+        {
+            m_event.mDuration = detail::now() - m_event.mStart;
+            detail::bufferOfThisThread().record(m_event);
+        }
+    }
+
+    auto TraceSpan::setDetail(std::string_view detail) -> void
+    {
+        if (m_active)
+        {
+            detail::copyDetail(detail, m_event.mDetail);
+        }
+    }
+
+} // namespace ccwc::algorithm
@@ -0,0 +1,110 @@
+#ifndef CCWC_ALGORITHM_TRACE_HPP
+#define CCWC_ALGORITHM_TRACE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ccwc::algorithm
+{
+
+    /**
+     * @brief A finished span as it is kept until the trace is written.
+     */
+    struct TraceEvent
+    {
+        /**
+         * @brief Longest detail kept; longer paths keep their end, which names the file.
+         */
+        static constexpr std::size_t DETAIL_SIZE = 48;
+
+        const char*                       mName{nullptr};
+        std::uint64_t                     mStart{0};
+        std::uint64_t                     mDuration{0};
+        std::uint64_t                     mBytes{0};
+        std::array<char, DETAIL_SIZE + 1> mDetail{};
+    };
+
+    /**
+     * @brief Start recording spans for `--trace=FILE`; the clock of the trace starts now.
+     */
+    auto enableTracing() -> void;
+
+    /**
+     * @brief Whether spans are recorded.
+     */
+    [[nodiscard]] auto isTracing() -> bool;
+
+    /**
+     * @brief Name the calling thread in the trace, e.g. "prefetcher".
+     * @param name A string literal.
+     */
+    auto nameTracedThread(const char* name) -> void;
+
+    /**
+     * @brief Write every recorded span as trace-event JSON, viewable in Perfetto or
+     * chrome://tracing. The threads that recorded them must have been joined.
+     * @throws ccwc::exception::FileOperationException If the file cannot be written.
+     */
+    auto writeTrace(const std::string& path) -> void;
+
+    /**
+     * @brief Records the time from its construction to its destruction as a span of the calling
+     * thread, if tracing is on.
+     *
+     * Each thread records into a buffer of its own, so recording takes no lock and does not
+     * make the threads wait for each other; a buffer that is full overwrites its oldest spans.
+     * When tracing is off a span costs a relaxed load.
+     */
+    class TraceSpan
+    {
+      private:
+        TraceEvent m_event;
+        bool       m_active{false};
+
+      public:
+        /**
+         * @brief Constructor: the span starts.
+         * @param name What the span is, a string literal: "open", "read", "count"...
+         * @param detail What it works on, usually the input; copied.
+         */
+        explicit TraceSpan(const char* name, std::string_view detail = {});
+
+        /**
+         * @brief Destructor: the span ends and is recorded.
+         */
+        ~TraceSpan();
+
+        TraceSpan(const TraceSpan&)                    = delete;
+        auto operator=(const TraceSpan&) -> TraceSpan& = delete;
+        TraceSpan(TraceSpan&&)                         = delete;
+        auto operator=(TraceSpan&&) -> TraceSpan&      = delete;
+
+        /**
+         * @brief Whether the span is recorded; a detail that is costly to build is only worth
+         * building then.
+         */
+        [[nodiscard]] auto active() const -> bool
+        {
+            return m_active;
+        }
+
+        /**
+         * @brief Set what the span works on.
+         */
+        auto setDetail(std::string_view detail) -> void;
+
+        /**
+         * @brief Set the bytes the span read or counted.
+         */
+        auto setBytes(std::uint64_t bytes) -> void
+        {
+            m_event.mBytes = bytes;
+        }
+    };
+
+} // namespace ccwc::algorithm
+
+#endif // CCWC_ALGORITHM_TRACE_HPP
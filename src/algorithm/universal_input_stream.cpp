@@ -1,17 +1,33 @@
 #include "universal_input_stream.hpp"
 
 #include "exception/exception.hpp"
+#include "file_descriptor.hpp"
+#include "incremental_counter.hpp"
+#include "parallel_frame_counter.hpp"
+#include "trace.hpp"
 
+#include <algorithm>
+#include <array>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <cerrno>
 #include <cstddef>
-#include <filesystem>
-#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
-#include <sstream>
+#include <new>
+#include <span>
 #include <string>
 #include <string_view>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
+#if defined(__linux__)
+#include <linux/fs.h>
+#endif
+
 namespace ccwc::algorithm
 {
     namespace detail
@@ -102,6 +118,11 @@ namespace ccwc::algorithm
             {
                 return std::cin.good();
             }
+
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "iostream";
+            }
         };
     } // namespace detail
 
@@ -109,15 +130,29 @@ namespace ccwc::algorithm
      * @brief Creates a new standard input stream.
      * @return A new standard input stream.
      */
-    auto createInputStream() -> std::unique_ptr<UniversalInputStream>
+    auto createInputStream(const InputStreamOptions& options)
+        -> std::unique_ptr<UniversalInputStream>
     {
+        if (options.mDecompress != CompressionFormat::NONE)
+        {
+            return createDecompressingInputStream("<stdin>", FileDescriptor{::dup(STDIN_FILENO)},
+                                                  true, options.mDecompress);
+        }
         return std::make_unique<detail::StandardInputStream>();
     }
 
     namespace detail
     {
         /**
-         * @brief Reads from a file via std::ifstream (buffered).
+         * @brief Size of the read buffer for regular files.
+         */
+        constexpr std::size_t FILE_READ_SIZE = static_cast<std::size_t>(64 * 1024); // 64KiB
+
+        /**
+         * @brief Reads from a regular file with buffered read() calls.
+         *
+         * The stream takes over the descriptor that was opened (and checked) by
+         * createInputStream, so the file is opened exactly once.
          */
         class BufferedFileInputStream : public UniversalInputStream
         {
@@ -128,18 +163,81 @@ namespace ccwc::algorithm
             std::string m_name;
 
             /**
-             * @brief The stream to read from.
+             * @brief The descriptor to read from.
              */
-            mutable std::ifstream m_stream;
+            FileDescriptor m_fd;
+
+            /**
+             * @brief Read buffer.
+             */
+            std::vector<unsigned char> m_buffer;
+
+            /**
+             * @brief Number of valid bytes in the buffer.
+             */
+            std::size_t m_filled{0};
+
+            /**
+             * @brief Read position inside the buffer.
+             */
+            std::size_t m_pos{0};
+
+            /**
+             * @brief False once end of file was reached or a read failed.
+             */
+            bool m_good{true};
+
+            /**
+             * @brief Number of read() calls issued.
+             */
+            std::uint64_t m_reads{0};
+
+            auto refill() -> bool
+            {
+                m_pos    = 0;
+                m_filled = 0;
+                if (!m_good)
+                {
+                    return false;
+                }
+
+                TraceSpan span("read", m_name);
+                ssize_t   bytesRead{-1};
+                do
+                {
+                    bytesRead = ::read(m_fd.get(), m_buffer.data(), m_buffer.size());
+                    ++m_reads;
+                } while (bytesRead < 0 && errno == EINTR);
+                span.setBytes(bytesRead > 0 ? static_cast<std::uint64_t>(bytesRead) : 0);
+
+                if (bytesRead < 0)
+                {
+                    // A failed read is not the end of the input: the counts would be truncated.
+                    m_good = false;
+                    throw ccwc::exception::FileOperationException(m_name + ": " +
+                                                                  std::strerror(errno));
+                }
+                if (bytesRead == 0)
+                {
+                    m_good = false;
+                    return false;
+                }
+                m_filled = static_cast<std::size_t>(bytesRead);
+                return true;
+            }
 
           public:
             /**
              * @brief Constructor.
              * @param filename The name of the file.
+             * @param fd Descriptor opened on the file.
+             * @param fileSize Size of the file, used to avoid a buffer larger than the file.
              */
-            explicit BufferedFileInputStream(std::string filename) : m_name(std::move(filename))
+            BufferedFileInputStream(std::string filename, FileDescriptor fd,
+                                    std::size_t fileSize)
+                : m_name(std::move(filename)), m_fd(std::move(fd)),
+                  m_buffer(std::clamp<std::size_t>(fileSize, 1, FILE_READ_SIZE))
             {
-                m_stream = std::ifstream(m_name, std::ios::binary);
             }
 
             /**
@@ -148,12 +246,12 @@ namespace ccwc::algorithm
             ~BufferedFileInputStream() override = default;
 
             /**
-             * @brief Copy constructor. explicitely deleted because ifstream is not copyable.
+             * @brief Copy constructor. explicitely deleted because the descriptor is owned.
              */
             BufferedFileInputStream(const BufferedFileInputStream&) = delete;
 
             /**
-             * @brief Copy assignment. explicitely deleted because ifstream is not copyable.
+             * @brief Copy assignment. explicitely deleted because the descriptor is owned.
              */
             auto operator=(const BufferedFileInputStream&) -> BufferedFileInputStream& = delete;
 
@@ -189,12 +287,11 @@ namespace ccwc::algorithm
              */
             [[nodiscard]] auto nextByte() -> std::optional<unsigned char> override
             {
-                char next_byte{};
-                if (m_stream.get(next_byte))
+                if (m_pos >= m_filled && !refill())
                 {
-                    return static_cast<unsigned char>(next_byte);
+                    return std::nullopt;
                 }
-                return std::nullopt;
+                return m_buffer[m_pos++];
             }
 
             /**
@@ -202,13 +299,14 @@ namespace ccwc::algorithm
              */
             [[nodiscard]] auto reset() -> bool override
             {
-                if (!m_stream.is_open())
+                if (::lseek(m_fd.get(), 0, SEEK_SET) != 0)
                 {
                     return false;
                 }
-                m_stream.clear();
-                m_stream.seekg(0, std::ios::beg);
-                return m_stream.good();
+                m_filled = 0;
+                m_pos    = 0;
+                m_good   = true;
+                return true;
             }
 
             /**
@@ -216,7 +314,17 @@ namespace ccwc::algorithm
              */
             [[nodiscard]] auto good() const -> bool override
             {
-                return m_stream.good();
+                return m_good;
+            }
+
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "read";
+            }
+
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return m_reads;
             }
         };
 
@@ -252,11 +360,13 @@ namespace ccwc::algorithm
              */
             explicit MemoryMappedFileInputStream(const std::string& filename) : m_name(filename)
             {
+                TraceSpan span("map", filename);
                 m_map.open(filename);
                 if (!m_map.is_open())
                 {
                     throw std::runtime_error("Failed to memory-map file: " + filename);
                 }
+                span.setBytes(m_map.size());
             }
 
             /**
@@ -335,6 +445,19 @@ namespace ccwc::algorithm
                 return m_map.is_open();
             }
 
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "mmap";
+            }
+
+            /**
+             * @brief The whole file is one mapped window.
+             */
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return 1;
+            }
+
             // ===== Additional helpers =====
 
             /**
@@ -346,28 +469,476 @@ namespace ccwc::algorithm
             }
         };
 
+        /**
+         * @brief Size of a single read issued against a device.
+         *
+         * Large reads keep the number of syscalls low; 1MiB is a multiple of every logical block
+         * size in use so it also satisfies the alignment rules of direct I/O.
+         */
+        constexpr std::size_t DEVICE_READ_SIZE = static_cast<std::size_t>(1024 * 1024); // 1MiB
+
+        /**
+         * @brief Heap buffer with a caller chosen alignment, as required by O_DIRECT reads.
+         */
+        class AlignedBuffer
+        {
+          private:
+            struct Deleter
+            {
+                std::align_val_t mAlignment;
+
+                void operator()(unsigned char* ptr) const
+                {
+                    ::operator delete[](ptr, mAlignment);
+                }
+            };
+
+            std::unique_ptr<unsigned char[], Deleter> m_data; // NOLINT(*-avoid-c-arrays)
+            std::size_t                               m_size{0};
+
+          public:
+            /**
+             * @brief Allocate `size` bytes aligned to `alignment`.
+             */
+            AlignedBuffer(std::size_t size, std::size_t alignment)
+                : m_data(static_cast<unsigned char*>(
+                             ::operator new[](size, std::align_val_t{alignment})),
+                         Deleter{std::align_val_t{alignment}}),
+                  m_size(size)
+            {
+            }
+
+            [[nodiscard]] auto data() const noexcept -> unsigned char*
+            {
+                return m_data.get();
+            }
+
+            [[nodiscard]] auto size() const noexcept -> std::size_t
+            {
+                return m_size;
+            }
+        };
+
+        /**
+         * @brief Reads a block device with large aligned reads.
+         *
+         * std::filesystem cannot size a block device, so the size is queried from the kernel via
+         * ioctl(BLKGETSIZE64). Reads are issued with pread() in DEVICE_READ_SIZE chunks into a
+         * buffer aligned to the logical block size, which allows the device to be opened with
+         * O_DIRECT to bypass the page cache when scanning volumes much larger than RAM.
+         */
+        class BlockDeviceInputStream : public UniversalInputStream
+        {
+          private:
+            std::string    m_name;          // Logical name (device path).
+            FileDescriptor m_fd;            // Open descriptor for the device.
+            std::uint64_t  m_deviceSize{0}; // Size of the device in bytes.
+            std::uint64_t  m_offset{0};     // Device offset of the next read.
+            AlignedBuffer  m_buffer;        // Aligned read buffer.
+            std::size_t    m_filled{0};     // Number of valid bytes in the buffer.
+            std::size_t    m_pos{0};        // Read position inside the buffer.
+            bool           m_good{true};    // False once a read has failed.
+            std::uint64_t  m_reads{0};      // Number of pread() calls issued.
+
+            /**
+             * @brief Query the logical block size, which direct I/O buffers must be aligned to.
+             */
+            [[nodiscard]] static auto logicalBlockSize(int fd) -> std::size_t
+            {
+                constexpr std::size_t DEFAULT_BLOCK_SIZE = 4096;
+#if defined(__linux__)
+                int blockSize{0};
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+                if (::ioctl(fd, BLKSSZGET, &blockSize) == 0 && blockSize > 0)
+                {
+                    return std::max(DEFAULT_BLOCK_SIZE, static_cast<std::size_t>(blockSize));
+                }
+#else
+                (void) fd;
+#endif
+                return DEFAULT_BLOCK_SIZE;
+            }
+
+            /**
+             * @brief Refill the buffer from the device.
+             * @return True if at least one byte is available afterwards.
+             */
+            auto refill() -> bool
+            {
+                m_pos    = 0;
+                m_filled = 0;
+                if (!m_good || m_offset >= m_deviceSize)
+                {
+                    return false;
+                }
+
+                TraceSpan span("read", m_name);
+                ssize_t   bytesRead{-1};
+                do
+                {
+                    bytesRead = ::pread(m_fd.get(), m_buffer.data(), m_buffer.size(),
+                                        static_cast<off_t>(m_offset));
+                    ++m_reads;
+                } while (bytesRead < 0 && errno == EINTR);
+                span.setBytes(bytesRead > 0 ? static_cast<std::uint64_t>(bytesRead) : 0);
+
+                if (bytesRead < 0)
+                {
+                    m_good = false;
+                    throw ccwc::exception::FileOperationException(m_name + ": " +
+                                                                  std::strerror(errno));
+                }
+                if (bytesRead == 0)
+                {
+                    m_good = false;
+                    return false;
+                }
+
+                auto remaining = m_deviceSize - m_offset;
+                m_filled       = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(static_cast<std::uint64_t>(bytesRead), remaining));
+                m_offset += static_cast<std::uint64_t>(bytesRead);
+                return m_filled > 0;
+            }
+
+          public:
+            /**
+             * @brief Constructor: takes ownership of an opened device descriptor.
+             * @param filename Path to the device.
+             * @param fd Descriptor opened on the device.
+             * @param deviceSize Size of the device in bytes.
+             */
+            BlockDeviceInputStream(std::string filename, FileDescriptor fd,
+                                   std::uint64_t deviceSize)
+                : m_name(std::move(filename)), m_fd(std::move(fd)), m_deviceSize(deviceSize),
+                  m_buffer(DEVICE_READ_SIZE, logicalBlockSize(m_fd.get()))
+            {
+            }
+
+            ~BlockDeviceInputStream() override = default;
+
+            BlockDeviceInputStream(const BlockDeviceInputStream&)                    = delete;
+            auto operator=(const BlockDeviceInputStream&) -> BlockDeviceInputStream& = delete;
+            BlockDeviceInputStream(BlockDeviceInputStream&&)                         = delete;
+            auto operator=(BlockDeviceInputStream&&) -> BlockDeviceInputStream&      = delete;
+
+            [[nodiscard]] auto name() const -> std::string override
+            {
+                return m_name;
+            }
+
+            [[nodiscard]] auto isStdin() const -> bool override
+            {
+                return false;
+            }
+
+            auto nextByte() -> std::optional<unsigned char> override
+            {
+                if (m_pos >= m_filled && !refill())
+                {
+                    return std::nullopt;
+                }
+                // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                return m_buffer.data()[m_pos++];
+                // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            }
+
+            auto reset() -> bool override
+            {
+                m_offset = 0;
+                m_filled = 0;
+                m_pos    = 0;
+                m_good   = true;
+                return true;
+            }
+
+            [[nodiscard]] auto good() const -> bool override
+            {
+                return m_good;
+            }
+
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "pread";
+            }
+
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return m_reads;
+            }
+
+            /**
+             * @brief Size of the device as reported by the kernel.
+             */
+            [[nodiscard]] auto size() const noexcept -> std::uint64_t
+            {
+                return m_deviceSize;
+            }
+        };
+
+        /**
+         * @brief Reads a character device, FIFO or socket as an unbounded stream.
+         *
+         * These files have no meaningful size, so they are read with large read() calls until the
+         * kernel reports end of file.
+         */
+        class CharacterDeviceInputStream : public UniversalInputStream
+        {
+          private:
+            std::string                m_name;      // Logical name (device path).
+            FileDescriptor             m_fd;        // Open descriptor for the device.
+            std::vector<unsigned char> m_buffer;    // Read buffer.
+            std::size_t                m_filled{0}; // Number of valid bytes in the buffer.
+            std::size_t                m_pos{0};    // Read position inside the buffer.
+            bool                       m_good{true};
+            std::uint64_t              m_reads{0};  // Number of read() calls issued.
+
+            auto refill() -> bool
+            {
+                m_pos    = 0;
+                m_filled = 0;
+                if (!m_good)
+                {
+                    return false;
+                }
+
+                TraceSpan span("read", m_name);
+                ssize_t   bytesRead{-1};
+                do
+                {
+                    bytesRead = ::read(m_fd.get(), m_buffer.data(), m_buffer.size());
+                    ++m_reads;
+                } while (bytesRead < 0 && errno == EINTR);
+                span.setBytes(bytesRead > 0 ? static_cast<std::uint64_t>(bytesRead) : 0);
+
+                if (bytesRead < 0)
+                {
+                    m_good = false;
+                    throw ccwc::exception::FileOperationException(m_name + ": " +
+                                                                  std::strerror(errno));
+                }
+                if (bytesRead == 0)
+                {
+                    m_good = false;
+                    return false;
+                }
+                m_filled = static_cast<std::size_t>(bytesRead);
+                return true;
+            }
+
+          public:
+            /**
+             * @brief Constructor: takes ownership of an opened descriptor.
+             * @param filename Path to the device.
+             * @param fd Descriptor opened on the device.
+             */
+            CharacterDeviceInputStream(std::string filename, FileDescriptor fd)
+                : m_name(std::move(filename)), m_fd(std::move(fd)), m_buffer(DEVICE_READ_SIZE)
+            {
+            }
+
+            ~CharacterDeviceInputStream() override = default;
+
+            CharacterDeviceInputStream(const CharacterDeviceInputStream&) = delete;
+            auto operator=(const CharacterDeviceInputStream&)
+                -> CharacterDeviceInputStream&                       = delete;
+            CharacterDeviceInputStream(CharacterDeviceInputStream&&) = delete;
+            auto operator=(CharacterDeviceInputStream&&) -> CharacterDeviceInputStream& = delete;
+
+            [[nodiscard]] auto name() const -> std::string override
+            {
+                return m_name;
+            }
+
+            [[nodiscard]] auto isStdin() const -> bool override
+            {
+                return false;
+            }
+
+            auto nextByte() -> std::optional<unsigned char> override
+            {
+                if (m_pos >= m_filled && !refill())
+                {
+                    return std::nullopt;
+                }
+                return m_buffer[m_pos++];
+            }
+
+            auto reset() -> bool override
+            {
+                return false; // unbounded streams cannot rewind
+            }
+
+            [[nodiscard]] auto good() const -> bool override
+            {
+                return m_good;
+            }
+
+            [[nodiscard]] auto backend() const -> std::string_view override
+            {
+                return "read";
+            }
+
+            [[nodiscard]] auto ioCalls() const -> std::uint64_t override
+            {
+                return m_reads;
+            }
+        };
+
+        /**
+         * @brief Creates the input stream for a block device.
+         */
+        auto createBlockDeviceStream(const std::string& filename, FileDescriptor fd,
+                                     const InputStreamOptions& options) -> InputStreamResult
+        {
+#if defined(__linux__)
+            if (options.mDirectIo)
+            {
+                // Direct I/O is optional; keep using the page cache if it is refused.
+                int flags = ::fcntl(fd.get(), F_GETFL); // NOLINT(*-vararg)
+                ::fcntl(fd.get(), F_SETFL, flags | O_DIRECT); // NOLINT(*-vararg)
+            }
+
+            std::uint64_t deviceSize{0};
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+            if (::ioctl(fd.get(), BLKGETSIZE64, &deviceSize) != 0)
+            {
+                return {nullptr, errno};
+            }
+            return {std::make_unique<BlockDeviceInputStream>(filename, std::move(fd), deviceSize),
+                    0};
+#else
+            (void) options;
+            return {std::make_unique<CharacterDeviceInputStream>(filename, std::move(fd)), 0};
+#endif
+        }
+
+        /**
+         * @brief Creates a decompressing stream for a file if decompression applies to it.
+         *
+         * Regular files are peeked with pread() so that, when the format is detected
+         * automatically, uncompressed files keep using the plain file streams, and files made of
+         * several independent zstd frames or BGZF blocks are counted in parallel. Unbounded inputs
+         * cannot be peeked without consuming them and always go through the decoder, which
+         * passes undetected data through unchanged.
+         *
+         * @return The stream, or nullptr if the file should be read as is (the descriptor is
+         * left untouched in that case).
+         */
+        auto createCompressedFileStream(const std::string& filename, FileDescriptor& fd,
+                                        bool isRegular, const InputStreamOptions& options)
+            -> std::unique_ptr<UniversalInputStream>
+        {
+            CompressionFormat format = options.mDecompress;
+
+            if (isRegular)
+            {
+                std::array<unsigned char, COMPRESSION_MAGIC_SIZE> header{};
+                ssize_t headerSize = ::pread(fd.get(), header.data(), header.size(), 0);
+
+                if (format == CompressionFormat::AUTO)
+                {
+                    format = headerSize <= 0
+                                 ? CompressionFormat::NONE
+                                 : detectCompressionFormat(std::span<const unsigned char>(
+                                       header.data(), static_cast<std::size_t>(headerSize)));
+                }
+                if (format == CompressionFormat::NONE)
+                {
+                    return nullptr;
+                }
+
+                // Files made of independent frames are decoded in parallel.
+                if (format == CompressionFormat::GZIP || format == CompressionFormat::ZSTD)
+                {
+                    if (auto framed = createParallelFramedInputStream(filename, format))
+                    {
+                        return framed;
+                    }
+                }
+            }
+
+            return createDecompressingInputStream(filename, std::move(fd), false, format);
+        }
+
         constexpr std::size_t MAX_MEMORY_MAPPED_FILE_SIZE =
             static_cast<std::size_t>(100 * 1024 * 1024); // 100MB
     } // namespace detail
 
-    auto createInputStream(const std::string& filename) -> std::unique_ptr<UniversalInputStream>
+    auto createInputStream(const std::string& filename, const InputStreamOptions& options)
+        -> InputStreamResult
     {
-        std::size_t file_size{0};
+        // A single open() + fstat() reports every common failure (ENOENT, EACCES, ...) as an
+        // errno, so vanished or unreadable files cost two syscalls and no exception.
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+        FileDescriptor fd{::open(filename.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (!fd.valid())
+        {
+            return {nullptr, errno};
+        }
+
+        struct stat info{};
+        if (::fstat(fd.get(), &info) != 0)
+        {
+            return {nullptr, errno};
+        }
+        if (S_ISDIR(info.st_mode))
+        {
+            return {nullptr, EISDIR};
+        }
 
-        try
+        if (options.mDecompress != CompressionFormat::NONE && !S_ISBLK(info.st_mode))
         {
-            file_size = std::filesystem::file_size(filename);
+            if (auto stream = detail::createCompressedFileStream(filename, fd,
+                                                                 S_ISREG(info.st_mode), options))
+            {
+                return {std::move(stream), 0, info};
+            }
         }
-        catch (const std::filesystem::filesystem_error& e)
+
+        if (S_ISBLK(info.st_mode))
         {
-            throw ccwc::exception::FileOperationException(e.what());
+            auto result    = detail::createBlockDeviceStream(filename, std::move(fd), options);
+            result.mStatus = info;
+            return result;
+        }
+        if (!S_ISREG(info.st_mode))
+        {
+            // Character devices, FIFOs and sockets.
+            return {std::make_unique<detail::CharacterDeviceInputStream>(filename, std::move(fd)),
+                    0, info};
         }
 
-        if (file_size < detail::MAX_MEMORY_MAPPED_FILE_SIZE)
+        FileDescriptor checkpointFd;
+        if (options.mCheckpointDirectory.has_value())
         {
-            return std::make_unique<detail::BufferedFileInputStream>(filename);
+            checkpointFd = FileDescriptor{::dup(fd.get())};
         }
 
-        return std::make_unique<detail::MemoryMappedFileInputStream>(filename);
+        std::unique_ptr<UniversalInputStream> stream;
+        auto                                  fileSize = static_cast<std::size_t>(info.st_size);
+        if (fileSize >= detail::MAX_MEMORY_MAPPED_FILE_SIZE)
+        {
+            try
+            {
+                stream = std::make_unique<detail::MemoryMappedFileInputStream>(filename);
+            }
+            catch (const std::exception&)
+            {
+                // Mapping is an optimisation; read the file instead if it is refused.
+            }
+        }
+        if (!stream)
+        {
+            stream = std::make_unique<detail::BufferedFileInputStream>(filename, std::move(fd),
+                                                                       fileSize);
+        }
+
+        if (checkpointFd.valid())
+        {
+            stream = createIncrementalInputStream(std::move(stream), std::move(checkpointFd),
+                                                  options.mCheckpointDirectory.value());
+        }
+        return {std::move(stream), 0, info};
     }
 } // namespace ccwc::algorithm
\ No newline at end of file
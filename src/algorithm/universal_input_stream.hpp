@@ -1,10 +1,16 @@
 #ifndef CCWC_ALGORITHM_UNIVERSAL_INPUT_STREAM_HPP
 #define CCWC_ALGORITHM_UNIVERSAL_INPUT_STREAM_HPP
 
+#include "compressed_input_stream.hpp"
+#include "counter.hpp"
+
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <sys/stat.h>
 
 namespace ccwc::algorithm
 {
@@ -21,6 +27,10 @@ namespace ccwc::algorithm
      *
      * In case of stdin, it will read from the standard input stream but will also be processed as
      * string stream.
+     *
+     * Block devices are sized via the kernel and read with large aligned reads (optionally with
+     * direct I/O), while character devices and FIFOs are treated as unbounded streams that are
+     * read until the kernel reports end of file.
      */
     class UniversalInputStream
     {
@@ -57,20 +67,113 @@ namespace ccwc::algorithm
          * @brief Check if the stream is still valid.
          */
         virtual bool good() const = 0;
+
+        /**
+         * @brief Count the whole stream at once, for streams that know a faster way than being
+         * read byte by byte (e.g. decoding independent frames in parallel).
+         * @return The counter, or std::nullopt if the stream has to be read with nextByte().
+         */
+        virtual std::optional<Counter> countAll()
+        {
+            return std::nullopt;
+        }
+
+        /**
+         * @brief How the stream reads its input (e.g. "read", "mmap"), as reported by `--stats`.
+         */
+        virtual std::string_view backend() const
+        {
+            return "stream";
+        }
+
+        /**
+         * @brief How the stream is counted, as reported by `--stats`.
+         */
+        virtual std::string_view kernel() const
+        {
+            return "state machine";
+        }
+
+        /**
+         * @brief Whether part of the counting runs on threads of the stream (a decoder, frame
+         * workers), which the CPU time and counters of the counting thread miss.
+         */
+        virtual bool countsOffThread() const
+        {
+            return false;
+        }
+
+        /**
+         * @brief Number of read syscalls issued or windows mapped so far, 0 if unknown.
+         */
+        virtual std::uint64_t ioCalls() const
+        {
+            return 0;
+        }
+    };
+
+    /**
+     * @brief Options that influence how an input stream is opened.
+     */
+    struct InputStreamOptions
+    {
+        /**
+         * @brief Bypass the page cache (O_DIRECT) when reading block devices.
+         */
+        bool mDirectIo{false};
+
+        /**
+         * @brief Decompress the input before counting (NONE counts the raw bytes).
+         */
+        CompressionFormat mDecompress{CompressionFormat::NONE};
+
+        /**
+         * @brief Directory of the checkpoints regular files are counted incrementally from.
+         */
+        std::optional<std::string> mCheckpointDirectory;
+    };
+
+    /**
+     * @brief Result of opening a file: either a stream or the errno explaining why not.
+     */
+    struct InputStreamResult
+    {
+        /**
+         * @brief The opened stream, or nullptr if opening failed.
+         */
+        std::unique_ptr<UniversalInputStream> mStream;
+
+        /**
+         * @brief The errno of the failed system call (0 on success).
+         */
+        int mErrno{0};
+
+        /**
+         * @brief fstat() of the descriptor the stream reads, valid if it was opened.
+         */
+        struct stat mStatus{};
     };
 
     /**
      * @brief Creates a new input stream for a file.
+     *
+     * Missing, unreadable and otherwise unopenable files are common in large batches, so they
+     * are reported through the result instead of an exception.
+     *
      * @param filename The name of the file.
-     * @return A new input stream for the file.
+     * @param options Options that influence how the file is opened.
+     * @return A new input stream for the file, or the errno explaining why it cannot be read.
      */
-    auto createInputStream(const std::string& filename) -> std::unique_ptr<UniversalInputStream>;
+    auto createInputStream(const std::string& filename, const InputStreamOptions& options = {})
+        -> InputStreamResult;
 
     /**
      * @brief Creates a new input stream for stdin.
+     * @param options Options that influence how stdin is read.
      * @return A new input stream for stdin.
      */
-    auto createInputStream() -> std::unique_ptr<UniversalInputStream>;
+    auto createInputStream(const InputStreamOptions& options = {})
+        -> std::unique_ptr<UniversalInputStream>;
 } // namespace ccwc::algorithm
 
 #endif // CCWC_ALGORITHM_UNIVERSAL_INPUT_STREAM_HPP
\ No newline at end of file
@@ -2,10 +2,16 @@
 
 #include "algorithm/universal_input_stream.hpp"
 #include "exception/exception.hpp"
+#include "file_list_reader.hpp"
 
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <span>
 #include <string_view>
+#include <utility>
 
 // PRIVATE INTERFACE
 
@@ -18,47 +24,500 @@ namespace ccwc::argument_parser
         m_output_formatter.addOption(formatOption);
     }
 
-    auto Arguments::addInputFile(const std::string& filename) -> void
+    auto Arguments::enableDirectIo() -> void
+    {
+        m_input_stream_options.mDirectIo = true;
+    }
+
+    auto Arguments::setDecompression(ccwc::algorithm::CompressionFormat format) -> void
+    {
+        m_input_stream_options.mDecompress = format;
+    }
+
+    auto Arguments::enableArchiveMode() -> void
+    {
+        if (m_recursive)
+        {
+            throw ccwc::exception::InvalidArgumentException("--tar cannot be combined with -r");
+        }
+        if (m_follow)
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--follow cannot be combined with --tar");
+        }
+        m_archive_mode = true;
+        if (m_input_stream_options.mDecompress == ccwc::algorithm::CompressionFormat::NONE)
+        {
+            // Archives are commonly compressed; detect that unless a format was given.
+            m_input_stream_options.mDecompress = ccwc::algorithm::CompressionFormat::AUTO;
+        }
+    }
+
+    auto Arguments::isArchiveMode() const -> bool
+    {
+        return m_archive_mode;
+    }
+
+    auto Arguments::enableRecursion(bool followSymlinks) -> void
+    {
+        if (m_archive_mode)
+        {
+            throw ccwc::exception::InvalidArgumentException("--tar cannot be combined with -r");
+        }
+        if (m_follow)
+        {
+            throw ccwc::exception::InvalidArgumentException("--follow cannot be combined with -r");
+        }
+        m_recursive                    = true;
+        m_walk_options.mFollowSymlinks = m_walk_options.mFollowSymlinks || followSymlinks;
+    }
+
+    auto Arguments::isRecursive() const -> bool
+    {
+        return m_recursive;
+    }
+
+    auto Arguments::addIncludePattern(std::string pattern) -> void
+    {
+        m_walk_options.mInclude.push_back(std::move(pattern));
+    }
+
+    auto Arguments::addExcludePattern(std::string pattern) -> void
+    {
+        m_walk_options.mExclude.push_back(std::move(pattern));
+    }
+
+    auto Arguments::walkOptions() const -> const ccwc::algorithm::WalkOptions&
+    {
+        return m_walk_options;
+    }
+
+    auto Arguments::enableRollup(std::size_t maxDepth) -> void
+    {
+        if (m_grouping.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--rollup cannot be combined with --group-by / --group");
+        }
+        if (isTotalOnly())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--total=only cannot be combined with --rollup");
+        }
+        if (m_selection.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--top / --sort-by / --min-* cannot be combined with --rollup");
+        }
+        m_rollup_depth = maxDepth;
+    }
+
+    auto Arguments::enableGrouping() -> ccwc::algorithm::GroupingOptions&
+    {
+        if (m_rollup_depth.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--rollup cannot be combined with --group-by / --group");
+        }
+        if (isTotalOnly())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--total=only cannot be combined with --group-by / --group");
+        }
+        if (m_follow)
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--follow cannot be combined with --group-by / --group");
+        }
+        if (m_selection.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--top / --sort-by / --min-* cannot be combined with --group-by / --group");
+        }
+        if (!m_grouping.has_value())
+        {
+            m_grouping.emplace();
+        }
+        return m_grouping.value();
+    }
+
+    auto Arguments::groupByExtension() -> void
+    {
+        enableGrouping().mByExtension = true;
+    }
+
+    auto Arguments::addGroupPattern(std::string pattern, std::string group) -> void
+    {
+        enableGrouping().mPatterns.emplace_back(std::move(pattern), std::move(group));
+    }
+
+    auto Arguments::isGrouped() const -> bool
+    {
+        return m_grouping.has_value();
+    }
+
+    auto Arguments::groupingOptions() const -> const ccwc::algorithm::GroupingOptions&
+    {
+        return m_grouping.value();
+    }
+
+    auto Arguments::enableSelection() -> ccwc::algorithm::SelectionOptions&
+    {
+        if (m_rollup_depth.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--top / --sort-by / --min-* cannot be combined with --rollup");
+        }
+        if (m_grouping.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--top / --sort-by / --min-* cannot be combined with --group-by / --group");
+        }
+        if (isTotalOnly())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--top / --sort-by / --min-* cannot be combined with --total=only");
+        }
+        if (m_follow)
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--follow cannot be combined with --top / --sort-by / --min-*");
+        }
+        if (!m_selection.has_value())
+        {
+            m_selection.emplace();
+        }
+        return m_selection.value();
+    }
+
+    auto Arguments::setTop(std::size_t count) -> void
+    {
+        enableSelection().mTop = count;
+    }
+
+    auto Arguments::setSortKey(ccwc::algorithm::SortKey key) -> void
+    {
+        enableSelection().mSortBy = key;
+    }
+
+    auto Arguments::setMinimum(ccwc::algorithm::SortKey key, std::size_t minimum) -> void
+    {
+        ccwc::algorithm::Counter& limits = enableSelection().mMinimum;
+        switch (key)
+        {
+        case ccwc::algorithm::SortKey::LINES:
+            limits.lines = minimum;
+            break;
+        case ccwc::algorithm::SortKey::WORDS:
+            limits.words = minimum;
+            break;
+        case ccwc::algorithm::SortKey::CHARS:
+            limits.multibyte = minimum;
+            break;
+        case ccwc::algorithm::SortKey::BYTES:
+            limits.bytes = minimum;
+            break;
+        }
+    }
+
+    auto Arguments::isSelecting() const -> bool
+    {
+        return m_selection.has_value();
+    }
+
+    auto Arguments::selectionOptions() const -> const ccwc::algorithm::SelectionOptions&
+    {
+        return m_selection.value();
+    }
+
+    auto Arguments::setCacheDirectory(std::string directory) -> void
+    {
+        m_cache_directory = std::move(directory);
+    }
+
+    auto Arguments::cacheDirectory() const -> const std::optional<std::string>&
+    {
+        return m_cache_directory;
+    }
+
+    auto Arguments::setCheckpointDirectory(std::string directory) -> void
+    {
+        m_input_stream_options.mCheckpointDirectory = std::move(directory);
+    }
+
+    auto Arguments::enableFollow() -> void
+    {
+        if (m_archive_mode || m_recursive || m_grouping.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--follow cannot be combined with --tar, -r or --group-by / --group");
+        }
+        if (m_selection.has_value())
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "--follow cannot be combined with --top / --sort-by / --min-*");
+        }
+        m_follow = true;
+    }
+
+    auto Arguments::isFollowing() const -> bool
+    {
+        return m_follow;
+    }
+
+    auto Arguments::setInterval(std::chrono::milliseconds interval) -> void
+    {
+        m_interval = interval;
+    }
+
+    auto Arguments::interval() const -> const std::optional<std::chrono::milliseconds>&
+    {
+        return m_interval;
+    }
+
+    auto Arguments::isIntervalReporting() const -> bool
     {
-        InputDataObject                                        inputDataObject;
-        std::unique_ptr<ccwc::algorithm::UniversalInputStream> inputStream{nullptr};
-        HealthStatus                                           healthStatus;
-        try
+        return m_interval.has_value() && !m_follow && m_input_data_objects.size() == 1 &&
+               m_input_data_objects.front().mIsStdin;
+    }
+
+    auto Arguments::checkInterval() const -> void
+    {
+        if (!m_interval.has_value() || m_follow)
+        {
+            return;
+        }
+        if (!isIntervalReporting())
         {
-            inputStream                   = ccwc::algorithm::createInputStream(filename);
-            inputDataObject.mInputStream  = std::move(inputStream);
-            inputDataObject.mHealthStatus = HealthStatus(true, "");
-            m_input_data_objects.emplace_back(std::move(inputDataObject));
+            throw ccwc::exception::InvalidArgumentException(
+                "--interval needs the standard input as the only input, or --follow");
         }
-        catch (const ccwc::exception::FileOperationException& e)
+        if (m_input_stream_options.mDecompress != ccwc::algorithm::CompressionFormat::NONE)
         {
-            inputStream                   = ccwc::algorithm::createInputStream();
-            inputDataObject.mInputStream  = std::move(inputStream);
-            inputDataObject.mHealthStatus = HealthStatus(false, e.what());
-            m_input_data_objects.emplace_back(std::move(inputDataObject));
+            throw ccwc::exception::InvalidArgumentException(
+                "--interval cannot be combined with --decompress");
         }
     }
 
+    auto Arguments::enableProgress() -> void
+    {
+        m_progress = true;
+    }
+
+    auto Arguments::showsProgress() const -> bool
+    {
+        return m_progress;
+    }
+
+    auto Arguments::enableStats() -> void
+    {
+        m_stats = true;
+    }
+
+    auto Arguments::showsStats() const -> bool
+    {
+        return m_stats;
+    }
+
+    auto Arguments::enablePerfCounters() -> void
+    {
+        m_perf_counters = true;
+    }
+
+    auto Arguments::showsPerfCounters() const -> bool
+    {
+        return m_perf_counters;
+    }
+
+    auto Arguments::setTracePath(std::string path) -> void
+    {
+        m_trace_path = std::move(path);
+    }
+
+    auto Arguments::tracePath() const -> const std::optional<std::string>&
+    {
+        return m_trace_path;
+    }
+
+    auto Arguments::setWidth(std::size_t width) -> void
+    {
+        m_output_formatter.setWidth(width);
+    }
+
+    auto Arguments::width() const -> const std::optional<std::size_t>&
+    {
+        return m_output_formatter.width();
+    }
+
+    auto Arguments::setReportFormat(ccwc::output_format_options::ReportFormat format) -> void
+    {
+        m_output_formatter.setReportFormat(format);
+    }
+
+    auto Arguments::setTotalMode(ccwc::output_format_options::TotalMode mode) -> void
+    {
+        if (mode == ccwc::output_format_options::TotalMode::ONLY)
+        {
+            if (m_rollup_depth.has_value())
+            {
+                throw ccwc::exception::InvalidArgumentException(
+                    "--total=only cannot be combined with --rollup");
+            }
+            if (m_grouping.has_value())
+            {
+                throw ccwc::exception::InvalidArgumentException(
+                    "--total=only cannot be combined with --group-by / --group");
+            }
+            if (m_selection.has_value())
+            {
+                throw ccwc::exception::InvalidArgumentException(
+                    "--top / --sort-by / --min-* cannot be combined with --total=only");
+            }
+        }
+        m_output_formatter.setTotalMode(mode);
+    }
+
+    auto Arguments::isTotalOnly() const -> bool
+    {
+        return m_output_formatter.totalMode() == ccwc::output_format_options::TotalMode::ONLY;
+    }
+
+    auto Arguments::canStreamRows() const -> bool
+    {
+        if (isTotalOnly())
+        {
+            return !m_follow && !isIntervalReporting();
+        }
+        return !m_archive_mode && !m_recursive && !m_follow && !m_rollup_depth.has_value() &&
+               !m_grouping.has_value() && !m_selection.has_value() && !isIntervalReporting();
+    }
+
+    auto Arguments::streamingReport(std::size_t width) const
+        -> ccwc::output_formatter::StreamingReport
+    {
+        std::cout.flush(); // keep the order with messages printed through std::cout
+        return {m_output_formatter, width};
+    }
+
+    auto Arguments::setFileList(std::string listName, char delimiter) -> void
+    {
+        m_file_list           = std::move(listName);
+        m_file_list_delimiter = delimiter;
+    }
+
+    auto Arguments::addFilesFromList(bool hasOperands) -> void
+    {
+        if (!m_file_list.has_value())
+        {
+            return;
+        }
+        if (hasOperands)
+        {
+            throw ccwc::exception::InvalidArgumentException(
+                "file operands cannot be combined with --files0-from / --files-from");
+        }
+
+        m_file_list_reader.emplace(m_file_list.value(), m_file_list_delimiter);
+    }
+
+    auto Arguments::addInputFile(const std::string& filename) -> void
+    {
+        m_input_data_objects.push_back({filename, false, HealthStatus(true, "")});
+    }
+
     auto Arguments::addStdin() -> void
     {
-        if (m_input_data_objects.empty())
+        // An empty file list means no input, not stdin.
+        if (m_input_data_objects.empty() && !m_file_list.has_value())
         {
-            InputDataObject inputDataObject;
-            inputDataObject.mInputStream  = ccwc::algorithm::createInputStream();
-            inputDataObject.mHealthStatus = HealthStatus(true, "");
-            m_input_data_objects.emplace_back(std::move(inputDataObject));
+            if (m_recursive)
+            {
+                // Like grep -r, a recursive count without operands walks the current directory.
+                m_input_data_objects.push_back({".", false, HealthStatus(true, "")});
+                return;
+            }
+            if (m_follow)
+            {
+                throw ccwc::exception::InvalidArgumentException("--follow needs file operands");
+            }
+            m_input_data_objects.push_back({"<stdin>", true, HealthStatus(true, "")});
         }
     }
 
+    auto Arguments::inputStreamOptions() const -> const ccwc::algorithm::InputStreamOptions&
+    {
+        return m_input_stream_options;
+    }
+
     auto Arguments::inputDataObjects() const -> const std::vector<InputDataObject>&
     {
         return m_input_data_objects;
     }
 
-    auto Arguments::formatOutput(const std::vector<ccwc::algorithm::Counter>& counters) const
-        -> void
+    auto Arguments::readsFileList() const -> bool
+    {
+        return m_file_list.has_value();
+    }
+
+    auto Arguments::takeInputs() -> InputSource
+    {
+        if (m_file_list_reader.has_value())
+        {
+            InputSource source(std::move(m_file_list_reader.value()));
+            m_file_list_reader.reset();
+            return source;
+        }
+        return InputSource(m_input_data_objects);
+    }
+
+    auto Arguments::formatOutput(const ccwc::algorithm::ResultStore& results) const -> void
+    {
+        std::cout.flush(); // keep the order with messages printed through std::cout
+        ccwc::output_formatter::OutputBuffer out;
+        if (m_rollup_depth.has_value())
+        {
+            m_output_formatter.formatRollup(results, m_rollup_depth.value(), out);
+        }
+        else
+        {
+            if (!isIntervalReporting()) // the rolling reports printed it
+            {
+                m_output_formatter.formatHeader(out);
+            }
+            m_output_formatter.formatFile(results, out);
+        }
+        m_output_formatter.formatTrailer(out);
+    }
+
+    auto Arguments::formatOutput(const ccwc::algorithm::ResultStore&   ungrouped,
+                                 const ccwc::algorithm::CounterGroups& groups) const -> void
     {
-        std::cout << m_output_formatter.formatFile(counters, m_input_data_objects) << '\n';
+        std::cout.flush();
+        ccwc::output_formatter::OutputBuffer out;
+        m_output_formatter.formatGroups(groups, ungrouped, out);
+        m_output_formatter.formatTrailer(out);
+    }
+
+    auto Arguments::formatHeader() const -> void
+    {
+        std::cout.flush();
+        ccwc::output_formatter::OutputBuffer out;
+        m_output_formatter.formatHeader(out);
+    }
+
+    auto Arguments::formatInterval(const ccwc::algorithm::Counter& delta,
+                                   const ccwc::algorithm::Counter& total) const -> void
+    {
+        ccwc::output_formatter::OutputBuffer out;
+        m_output_formatter.formatInterval(delta, total, out);
+        m_output_formatter.formatTrailer(out);
+    }
+
+    auto Arguments::formatPartial(const ccwc::algorithm::Counter& partial) const -> void
+    {
+        ccwc::output_formatter::OutputBuffer out;
+        m_output_formatter.formatPartial(partial, out);
+        m_output_formatter.formatTrailer(out);
     }
 
     auto Arguments::normalizeFormattingOptions() -> void
@@ -75,6 +534,111 @@ namespace ccwc
 
     namespace detail
     {
+        /**
+         * @brief Parse the value of `--rollup=dir[:depth]`.
+         */
+        auto parseRollup(std::string_view value) -> std::size_t
+        {
+            constexpr std::string_view KIND = "dir";
+
+            if (value == KIND)
+            {
+                return std::numeric_limits<std::size_t>::max();
+            }
+            std::size_t depth{0};
+            if (value.starts_with(KIND) && value.size() > KIND.size() + 1 &&
+                value[KIND.size()] == ':')
+            {
+                std::string_view digits = value.substr(KIND.size() + 1);
+                const char* last  = digits.data() + digits.size();
+                auto [end, error] = std::from_chars(digits.data(), last, depth);
+                if (error == std::errc() && end == last)
+                {
+                    return depth;
+                }
+            }
+            throw ccwc::exception::InvalidArgumentException("Invalid rollup: " +
+                                                            std::string(value));
+        }
+
+        /**
+         * @brief Parse the value of `--width=N`.
+         */
+        auto parseWidth(std::string_view value) -> std::size_t
+        {
+            constexpr std::size_t MAX_WIDTH = 20; // digits of the largest count
+
+            std::size_t width{0};
+            const char* last  = value.data() + value.size();
+            auto [end, error] = std::from_chars(value.data(), last, width);
+            if (error != std::errc() || end != last || width == 0 || width > MAX_WIDTH)
+            {
+                throw ccwc::exception::InvalidArgumentException("Invalid width: " +
+                                                                std::string(value));
+            }
+            return width;
+        }
+
+        /**
+         * @brief Parse the value of `--top=N` or `--min-KEY=N`.
+         */
+        auto parseCount(std::string_view arg) -> std::size_t
+        {
+            std::string_view value = arg.substr(arg.find('=') + 1);
+
+            std::size_t count{0};
+            const char* last  = value.data() + value.size();
+            auto [end, error] = std::from_chars(value.data(), last, count);
+            if (error != std::errc() || end != last)
+            {
+                throw ccwc::exception::InvalidArgumentException("Invalid count: " +
+                                                                std::string(arg));
+            }
+            return count;
+        }
+
+        /**
+         * @brief Parse the key of `--sort-by=KEY` or `--min-KEY=N`.
+         */
+        auto parseSortKey(std::string_view arg, std::string_view name) -> ccwc::algorithm::SortKey
+        {
+            auto key = ccwc::algorithm::parseSortKey(name);
+            if (!key.has_value())
+            {
+                throw ccwc::exception::InvalidArgumentException("Invalid sort key: " +
+                                                                std::string(arg));
+            }
+            return key.value();
+        }
+
+        /**
+         * @brief Parse a duration such as "10s", "500ms", "2m" or "1h"; plain numbers are seconds.
+         */
+        auto parseInterval(std::string_view value) -> std::chrono::milliseconds
+        {
+            constexpr std::array<std::pair<std::string_view, std::int64_t>, 5> UNITS{{
+                {"ms", 1},
+                {"s", 1000},
+                {"m", 60'000},
+                {"h", 3'600'000},
+                {"", 1000},
+            }};
+
+            std::int64_t amount{0};
+            const char*  last  = value.data() + value.size();
+            auto [unit, error] = std::from_chars(value.data(), last, amount);
+
+            std::string_view suffix(unit, static_cast<std::size_t>(last - unit));
+            for (const auto& [name, milliseconds] : UNITS)
+            {
+                if (error == std::errc() && amount > 0 && suffix == name)
+                {
+                    return std::chrono::milliseconds(amount * milliseconds);
+                }
+            }
+            throw ccwc::exception::InvalidArgumentException("Invalid interval: " +
+                                                            std::string(value));
+        }
 
         auto processOption(std::string_view arg, ccwc::argument_parser::Arguments& args) -> void
         {
@@ -98,6 +662,148 @@ namespace ccwc
                 args.addFormattingOptions(
                     ccwc::output_format_options::OutputFormatOptions::FORMAT_MULTIBYTE);
             }
+            else if (arg == "--direct")
+            {
+                args.enableDirectIo();
+            }
+            else if (arg.starts_with("--files0-from="))
+            {
+                args.setFileList(std::string(arg.substr(arg.find('=') + 1)), '\0');
+            }
+            else if (arg.starts_with("--files-from="))
+            {
+                args.setFileList(std::string(arg.substr(arg.find('=') + 1)), '\n');
+            }
+            else if (arg == "-r" || arg == "--recursive")
+            {
+                args.enableRecursion(false);
+            }
+            else if (arg == "-R" || arg == "--dereference-recursive")
+            {
+                args.enableRecursion(true);
+            }
+            else if (arg.starts_with("--include="))
+            {
+                args.addIncludePattern(std::string(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--exclude="))
+            {
+                args.addExcludePattern(std::string(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--rollup="))
+            {
+                args.enableRollup(parseRollup(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg == "--group-by=ext")
+            {
+                args.groupByExtension();
+            }
+            else if (arg.starts_with("--group="))
+            {
+                // GLOB=NAME; the glob may contain '=' itself, the group name may not.
+                std::string_view value  = arg.substr(arg.find('=') + 1);
+                std::size_t      equals = value.rfind('=');
+                if (equals == std::string_view::npos || equals == 0 || equals + 1 == value.size())
+                {
+                    throw ccwc::exception::InvalidArgumentException("Invalid group: " +
+                                                                    std::string(arg));
+                }
+                args.addGroupPattern(std::string(value.substr(0, equals)),
+                                     std::string(value.substr(equals + 1)));
+            }
+            else if (arg.starts_with("--cache="))
+            {
+                args.setCacheDirectory(std::string(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--trace="))
+            {
+                args.setTracePath(std::string(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--checkpoint="))
+            {
+                args.setCheckpointDirectory(std::string(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--interval="))
+            {
+                args.setInterval(parseInterval(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--width="))
+            {
+                args.setWidth(parseWidth(arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--format="))
+            {
+                auto format = ccwc::output_format_options::parseReportFormat(
+                    arg.substr(arg.find('=') + 1));
+                if (!format.has_value())
+                {
+                    throw ccwc::exception::InvalidArgumentException("Invalid format: " +
+                                                                    std::string(arg));
+                }
+                args.setReportFormat(format.value());
+            }
+            else if (arg.starts_with("--total="))
+            {
+                auto mode =
+                    ccwc::output_format_options::parseTotalMode(arg.substr(arg.find('=') + 1));
+                if (!mode.has_value())
+                {
+                    throw ccwc::exception::InvalidArgumentException("Invalid total mode: " +
+                                                                    std::string(arg));
+                }
+                args.setTotalMode(mode.value());
+            }
+            else if (arg.starts_with("--top="))
+            {
+                args.setTop(parseCount(arg));
+            }
+            else if (arg.starts_with("--sort-by="))
+            {
+                args.setSortKey(parseSortKey(arg, arg.substr(arg.find('=') + 1)));
+            }
+            else if (arg.starts_with("--min-") && arg.find('=') != std::string_view::npos)
+            {
+                constexpr std::size_t PREFIX = std::string_view("--min-").size();
+
+                std::size_t equals = arg.find('=');
+                args.setMinimum(parseSortKey(arg, arg.substr(PREFIX, equals - PREFIX)),
+                                parseCount(arg));
+            }
+            else if (arg == "--progress")
+            {
+                args.enableProgress();
+            }
+            else if (arg == "--stats")
+            {
+                args.enableStats();
+            }
+            else if (arg == "--perf-counters")
+            {
+                args.enablePerfCounters();
+            }
+            else if (arg == "--follow")
+            {
+                args.enableFollow();
+            }
+            else if (arg == "--tar")
+            {
+                args.enableArchiveMode();
+            }
+            else if (arg == "--decompress")
+            {
+                args.setDecompression(ccwc::algorithm::CompressionFormat::AUTO);
+            }
+            else if (arg.starts_with("--decompress="))
+            {
+                auto format =
+                    ccwc::algorithm::parseCompressionFormat(arg.substr(arg.find('=') + 1));
+                if (!format.has_value())
+                {
+                    throw ccwc::exception::InvalidArgumentException("Invalid compression format: " +
+                                                                    std::string(arg));
+                }
+                args.setDecompression(format.value());
+            }
             else
             {
                 throw ccwc::exception::InvalidArgumentException("Invalid argument: " +
@@ -114,6 +820,9 @@ namespace ccwc
 
         bool firstArgument = true;
 
+        // File operands are collected first so a file list can reject being combined with them.
+        std::vector<std::string_view> filenames;
+
         for (char* arg : safeArgs)
         {
             if (firstArgument)
@@ -130,11 +839,18 @@ namespace ccwc
             }
             else
             {
-                args.addInputFile(std::string(argView));
+                filenames.push_back(argView);
             }
         }
 
+        args.addFilesFromList(!filenames.empty());
+        for (const auto& filename : filenames)
+        {
+            args.addInputFile(std::string(filename));
+        }
+
         args.addStdin();
+        args.checkInterval();
         args.normalizeFormattingOptions();
 
         return args;
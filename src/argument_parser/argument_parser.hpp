@@ -1,9 +1,21 @@
 #ifndef CCWC_ARGUMENT_PARSER_HPP
 #define CCWC_ARGUMENT_PARSER_HPP
 
+#include "algorithm/counter_groups.hpp"
+#include "algorithm/directory_walker.hpp"
+#include "algorithm/result_store.hpp"
+#include "algorithm/row_selector.hpp"
+#include "algorithm/universal_input_stream.hpp"
+#include "argument_parser/file_list_reader.hpp"
 #include "argument_parser/input_objects.hpp"
+#include "argument_parser/input_source.hpp"
 #include "output_formatter/output_formatter.hpp"
+#include "output_formatter/streaming_report.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace ccwc::argument_parser
@@ -22,10 +34,105 @@ namespace ccwc::argument_parser
         ccwc::output_formatter::OutputFormatter m_output_formatter;
 
         /**
-         * @brief The health status of the arguments.
+         * @brief The inputs named on the command line (or the standard input).
          */
         std::vector<InputDataObject> m_input_data_objects;
 
+        /**
+         * @brief Options used when opening the input files.
+         */
+        ccwc::algorithm::InputStreamOptions m_input_stream_options;
+
+        /**
+         * @brief Whether the inputs are tar archives whose members are counted.
+         */
+        bool m_archive_mode{false};
+
+        /**
+         * @brief Whether directories given as inputs are walked recursively.
+         */
+        bool m_recursive{false};
+
+        /**
+         * @brief Which files a recursive walk counts.
+         */
+        ccwc::algorithm::WalkOptions m_walk_options;
+
+        /**
+         * @brief Maximum depth of the per-directory totals, if `--rollup` was given.
+         */
+        std::optional<std::size_t> m_rollup_depth;
+
+        /**
+         * @brief How files are grouped, if `--group-by` / `--group` was given.
+         */
+        std::optional<ccwc::algorithm::GroupingOptions> m_grouping;
+
+        /**
+         * @brief Which rows are printed, if `--top`, `--sort-by` or a `--min-*` was given.
+         */
+        std::optional<ccwc::algorithm::SelectionOptions> m_selection;
+
+        /**
+         * @brief Directory of the result cache, if `--cache` was given.
+         */
+        std::optional<std::string> m_cache_directory;
+
+        /**
+         * @brief Whether the inputs are followed as they grow (`--follow`).
+         */
+        bool m_follow{false};
+
+        /**
+         * @brief Time between two rolling reports, if `--interval` was given.
+         */
+        std::optional<std::chrono::milliseconds> m_interval;
+
+        /**
+         * @brief Whether progress is reported every second (`--progress`).
+         */
+        bool m_progress{false};
+
+        /**
+         * @brief Whether the inputs and the run are measured (`--stats`).
+         */
+        bool m_stats{false};
+
+        /**
+         * @brief Whether the stages are measured with hardware counters (`--perf-counters`).
+         */
+        bool m_perf_counters{false};
+
+        /**
+         * @brief File the trace is written to, if `--trace` was given.
+         */
+        std::optional<std::string> m_trace_path;
+
+        /**
+         * @brief Turn grouping on, rejecting `--rollup`.
+         */
+        auto enableGrouping() -> ccwc::algorithm::GroupingOptions&;
+
+        /**
+         * @brief Turn row selection on, rejecting the reports that are not made of the rows.
+         */
+        auto enableSelection() -> ccwc::algorithm::SelectionOptions&;
+
+        /**
+         * @brief File list given with `--files0-from` / `--files-from`, if any.
+         */
+        std::optional<std::string> m_file_list;
+
+        /**
+         * @brief Character terminating the names in the file list.
+         */
+        char m_file_list_delimiter{'\0'};
+
+        /**
+         * @brief The file list, opened while the arguments are parsed and read while counting.
+         */
+        std::optional<FileListReader> m_file_list_reader;
+
       public:
         /**
          * @brief Constructor for the Arguments class.
@@ -49,6 +156,242 @@ namespace ccwc::argument_parser
         auto addFormattingOptions(ccwc::output_format_options::OutputFormatOptions formatOption)
             -> void;
 
+        /**
+         * @brief Enable direct I/O (bypassing the page cache) for block devices.
+         */
+        auto enableDirectIo() -> void;
+
+        /**
+         * @brief Decompress the inputs with the given format before counting them.
+         */
+        auto setDecompression(ccwc::algorithm::CompressionFormat format) -> void;
+
+        /**
+         * @brief Treat the inputs as (optionally compressed) tar archives.
+         */
+        auto enableArchiveMode() -> void;
+
+        /**
+         * @brief Whether the inputs are tar archives.
+         */
+        [[nodiscard]] auto isArchiveMode() const -> bool;
+
+        /**
+         * @brief Count the files below directory inputs.
+         * @param followSymlinks Whether symbolic links inside the directories are followed.
+         */
+        auto enableRecursion(bool followSymlinks) -> void;
+
+        /**
+         * @brief Whether directory inputs are walked recursively.
+         */
+        [[nodiscard]] auto isRecursive() const -> bool;
+
+        /**
+         * @brief Only count files whose name matches one of the include patterns.
+         */
+        auto addIncludePattern(std::string pattern) -> void;
+
+        /**
+         * @brief Skip files and directories whose name matches the pattern.
+         */
+        auto addExcludePattern(std::string pattern) -> void;
+
+        /**
+         * @brief Options of the recursive walk.
+         */
+        [[nodiscard]] auto walkOptions() const -> const ccwc::algorithm::WalkOptions&;
+
+        /**
+         * @brief Print per-directory totals instead of one row per file.
+         * @param maxDepth Deepest directory level printed.
+         */
+        auto enableRollup(std::size_t maxDepth) -> void;
+
+        /**
+         * @brief Group files by their extension when no `--group` pattern matches them.
+         */
+        auto groupByExtension() -> void;
+
+        /**
+         * @brief Put the files matching a glob pattern into a group.
+         */
+        auto addGroupPattern(std::string pattern, std::string group) -> void;
+
+        /**
+         * @brief Whether per-group totals are printed instead of one row per file.
+         */
+        [[nodiscard]] auto isGrouped() const -> bool;
+
+        /**
+         * @brief How files are grouped; only valid if isGrouped().
+         */
+        [[nodiscard]] auto groupingOptions() const -> const ccwc::algorithm::GroupingOptions&;
+
+        /**
+         * @brief Print only the `count` rows with the largest sort key.
+         */
+        auto setTop(std::size_t count) -> void;
+
+        /**
+         * @brief Order the rows by a count, largest first.
+         */
+        auto setSortKey(ccwc::algorithm::SortKey key) -> void;
+
+        /**
+         * @brief Drop the inputs with less than `minimum` of a count.
+         */
+        auto setMinimum(ccwc::algorithm::SortKey key, std::size_t minimum) -> void;
+
+        /**
+         * @brief Whether the rows are selected or sorted while the inputs are counted.
+         */
+        [[nodiscard]] auto isSelecting() const -> bool;
+
+        /**
+         * @brief Which rows are printed; only valid if isSelecting().
+         */
+        [[nodiscard]] auto selectionOptions() const -> const ccwc::algorithm::SelectionOptions&;
+
+        /**
+         * @brief Keep the counters of regular files in a cache directory across runs.
+         */
+        auto setCacheDirectory(std::string directory) -> void;
+
+        /**
+         * @brief The cache directory, if caching is enabled.
+         */
+        [[nodiscard]] auto cacheDirectory() const -> const std::optional<std::string>&;
+
+        /**
+         * @brief Count regular files incrementally from checkpoints kept in a directory.
+         */
+        auto setCheckpointDirectory(std::string directory) -> void;
+
+        /**
+         * @brief Keep the input files open and report their counts again as they grow.
+         */
+        auto enableFollow() -> void;
+
+        /**
+         * @brief Whether the inputs are followed.
+         */
+        [[nodiscard]] auto isFollowing() const -> bool;
+
+        /**
+         * @brief Report rolling counts of the standard input (or of followed files) every
+         * interval.
+         */
+        auto setInterval(std::chrono::milliseconds interval) -> void;
+
+        /**
+         * @brief The interval of `--interval`, if given.
+         */
+        [[nodiscard]] auto interval() const -> const std::optional<std::chrono::milliseconds>&;
+
+        /**
+         * @brief Whether the standard input is counted with rolling reports.
+         */
+        [[nodiscard]] auto isIntervalReporting() const -> bool;
+
+        /**
+         * @brief Reject `--interval` when there is neither the standard input nor `--follow`.
+         */
+        auto checkInterval() const -> void;
+
+        /**
+         * @brief Report the progress of the count on stderr every second.
+         */
+        auto enableProgress() -> void;
+
+        /**
+         * @brief Whether progress is reported every second.
+         */
+        [[nodiscard]] auto showsProgress() const -> bool;
+
+        /**
+         * @brief Measure each input and the whole run and report it on stderr.
+         */
+        auto enableStats() -> void;
+
+        /**
+         * @brief Whether the inputs and the run are measured.
+         */
+        [[nodiscard]] auto showsStats() const -> bool;
+
+        /**
+         * @brief Read the hardware counters around the stages and report them on stderr.
+         */
+        auto enablePerfCounters() -> void;
+
+        /**
+         * @brief Whether the stages are measured with hardware counters.
+         */
+        [[nodiscard]] auto showsPerfCounters() const -> bool;
+
+        /**
+         * @brief Record spans of the run on every thread and write them to a file at the end.
+         */
+        auto setTracePath(std::string path) -> void;
+
+        /**
+         * @brief The file the trace is written to, if tracing is enabled.
+         */
+        [[nodiscard]] auto tracePath() const -> const std::optional<std::string>&;
+
+        /**
+         * @brief Use a fixed width for the numbers (`--width`).
+         */
+        auto setWidth(std::size_t width) -> void;
+
+        /**
+         * @brief The fixed width of the numbers, if one was given.
+         */
+        [[nodiscard]] auto width() const -> const std::optional<std::size_t>&;
+
+        /**
+         * @brief Select the layout of the report (`--format`).
+         */
+        auto setReportFormat(ccwc::output_format_options::ReportFormat format) -> void;
+
+        /**
+         * @brief Select when the total row is printed (`--total`).
+         */
+        auto setTotalMode(ccwc::output_format_options::TotalMode mode) -> void;
+
+        /**
+         * @brief Whether only the total is printed (`--total=only`), so the counted inputs can be
+         * summed up instead of kept.
+         */
+        [[nodiscard]] auto isTotalOnly() const -> bool;
+
+        /**
+         * @brief Whether the output is one row per input in input order, so each row can be
+         * printed as soon as its input is counted; or, with `--total=only`, the failures and the
+         * total, whatever the inputs are.
+         */
+        [[nodiscard]] auto canStreamRows() const -> bool;
+
+        /**
+         * @brief Start a report that prints the rows as the inputs are counted.
+         * @param width Width of the numbers; it must be known before the first row.
+         */
+        [[nodiscard]] auto streamingReport(std::size_t width) const
+            -> ccwc::output_formatter::StreamingReport;
+
+        /**
+         * @brief Read the input files from a list instead of the command line.
+         * @param listName Path of the list, or "-" for stdin.
+         * @param delimiter Character terminating each name ('\0' or '\n').
+         */
+        auto setFileList(std::string listName, char delimiter) -> void;
+
+        /**
+         * @brief Open the file list; its names are read by the InputSource as they are counted.
+         * @param hasOperands Whether file operands were also given on the command line.
+         */
+        auto addFilesFromList(bool hasOperands) -> void;
+
         /**
          * @brief Add an input file to the arguments.
          */
@@ -60,14 +403,55 @@ namespace ccwc::argument_parser
         auto addStdin() -> void;
 
         /**
-         * @brief Get the input data objects.
+         * @brief Options used when the counting stage opens the inputs.
+         */
+        [[nodiscard]] auto inputStreamOptions() const
+            -> const ccwc::algorithm::InputStreamOptions&;
+
+        /**
+         * @brief The inputs named on the command line; empty when they come from a file list.
          */
         [[nodiscard]] auto inputDataObjects() const -> const std::vector<InputDataObject>&;
 
+        /**
+         * @brief Whether the inputs come from `--files0-from` / `--files-from`, so they are
+         * only known as they are counted.
+         */
+        [[nodiscard]] auto readsFileList() const -> bool;
+
+        /**
+         * @brief Take the inputs to count, the operands or the file list; only once. The
+         * operands stay available through inputDataObjects().
+         */
+        [[nodiscard]] auto takeInputs() -> InputSource;
+
         /**
          * @brief Format the output.
          */
-        auto formatOutput(const std::vector<ccwc::algorithm::Counter>& counters) const -> void;
+        auto formatOutput(const ccwc::algorithm::ResultStore& results) const -> void;
+
+        /**
+         * @brief Format the per-group totals and the inputs that were not grouped.
+         */
+        auto formatOutput(const ccwc::algorithm::ResultStore&   ungrouped,
+                          const ccwc::algorithm::CounterGroups& groups) const -> void;
+
+        /**
+         * @brief Format the header of a report whose rows are printed one by one, e.g. the
+         * rolling reports; only CSV and TSV have one.
+         */
+        auto formatHeader() const -> void;
+
+        /**
+         * @brief Format a rolling report of the standard input.
+         */
+        auto formatInterval(const ccwc::algorithm::Counter& delta,
+                            const ccwc::algorithm::Counter& total) const -> void;
+
+        /**
+         * @brief Format the totals of an interrupted count.
+         */
+        auto formatPartial(const ccwc::algorithm::Counter& partial) const -> void;
 
         /**
          * @brief Normalize the formatting options.
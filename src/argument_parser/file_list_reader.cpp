@@ -0,0 +1,112 @@
+#include "file_list_reader.hpp"
+
+#include "exception/exception.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ccwc::argument_parser
+{
+    namespace detail
+    {
+        constexpr std::size_t FILE_LIST_BUFFER_SIZE = static_cast<std::size_t>(64 * 1024); // 64KiB
+
+        auto openList(const std::string& listName) -> ccwc::algorithm::FileDescriptor
+        {
+            if (listName == "-")
+            {
+                return ccwc::algorithm::FileDescriptor{::dup(STDIN_FILENO)};
+            }
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+            ccwc::algorithm::FileDescriptor fd{::open(listName.c_str(), O_RDONLY | O_CLOEXEC)};
+            if (!fd.valid())
+            {
+                throw ccwc::exception::FileOperationException(
+                    "cannot open '" + listName + "' for reading: " + std::strerror(errno));
+            }
+            return fd;
+        }
+    } // namespace detail
+
+    FileListReader::FileListReader(std::string listName, char delimiter)
+        : m_fd(detail::openList(listName)), m_listName(std::move(listName)),
+          m_delimiter(delimiter), m_buffer(detail::FILE_LIST_BUFFER_SIZE)
+    {
+    }
+
+    auto FileListReader::isStdin() const -> bool
+    {
+        return m_listName == "-";
+    }
+
+    auto FileListReader::refill() -> bool
+    {
+        m_pos    = 0;
+        m_filled = 0;
+        if (m_eof)
+        {
+            return false;
+        }
+
+        ssize_t bytesRead{-1};
+        do
+        {
+            bytesRead = ::read(m_fd.get(), m_buffer.data(), m_buffer.size());
+        } while (bytesRead < 0 && errno == EINTR);
+
+        if (bytesRead < 0)
+        {
+            throw ccwc::exception::FileOperationException(m_listName + ": read error: " +
+                                                          std::strerror(errno));
+        }
+        if (bytesRead == 0)
+        {
+            m_eof = true;
+            return false;
+        }
+        m_filled = static_cast<std::size_t>(bytesRead);
+        return true;
+    }
+
+    auto FileListReader::next() -> std::optional<std::string>
+    {
+        std::string name;
+        bool        sawAny{false};
+
+        while (true)
+        {
+            if (m_pos >= m_filled && !refill())
+            {
+                // A final name without a terminator still counts.
+                if (sawAny && !(m_delimiter == '\n' && name.empty()))
+                {
+                    return name;
+                }
+                return std::nullopt;
+            }
+
+            auto begin = m_buffer.begin() + static_cast<std::ptrdiff_t>(m_pos);
+            auto end   = m_buffer.begin() + static_cast<std::ptrdiff_t>(m_filled);
+            auto found = std::find(begin, end, m_delimiter);
+
+            name.append(begin, found);
+            sawAny = true;
+            m_pos  = static_cast<std::size_t>(found - m_buffer.begin());
+
+            if (found != end)
+            {
+                ++m_pos; // consume the delimiter
+                if (m_delimiter == '\n' && name.empty())
+                {
+                    sawAny = false;
+                    continue; // skip blank lines
+                }
+                return name;
+            }
+        }
+    }
+
+} // namespace ccwc::argument_parser
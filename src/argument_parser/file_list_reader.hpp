@@ -0,0 +1,92 @@
+#ifndef CCWC_ARGUMENT_PARSER_FILE_LIST_READER_HPP
+#define CCWC_ARGUMENT_PARSER_FILE_LIST_READER_HPP
+
+#include "algorithm/file_descriptor.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ccwc::argument_parser
+{
+
+    /**
+     * @brief Reads a list of file names (as given to `--files0-from` / `--files-from`) one name
+     * at a time.
+     *
+     * The list is read through a fixed-size buffer, so lists with millions of names are never
+     * held in memory as a whole.
+     */
+    class FileListReader
+    {
+      private:
+        /**
+         * @brief The list being read.
+         */
+        ccwc::algorithm::FileDescriptor m_fd;
+
+        /**
+         * @brief Name of the list, for error messages.
+         */
+        std::string m_listName;
+
+        /**
+         * @brief Character terminating each name ('\0' or '\n').
+         */
+        char m_delimiter;
+
+        /**
+         * @brief Read buffer.
+         */
+        std::vector<char> m_buffer;
+
+        /**
+         * @brief Number of valid bytes in the buffer.
+         */
+        std::size_t m_filled{0};
+
+        /**
+         * @brief Read position inside the buffer.
+         */
+        std::size_t m_pos{0};
+
+        /**
+         * @brief Whether the end of the list was reached.
+         */
+        bool m_eof{false};
+
+        /**
+         * @brief Refill the buffer.
+         * @return True if more bytes are available.
+         */
+        auto refill() -> bool;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param listName Path of the list, or "-" for stdin.
+         * @param delimiter Character terminating each name.
+         * @throws ccwc::exception::FileOperationException if the list cannot be opened.
+         */
+        FileListReader(std::string listName, char delimiter);
+
+        /**
+         * @brief Whether the list is read from stdin.
+         */
+        [[nodiscard]] auto isStdin() const -> bool;
+
+        /**
+         * @brief Get the next name in the list.
+         *
+         * With a newline delimiter empty lines are skipped; with NUL delimiters an empty name is
+         * returned as is so that it can be reported, like GNU wc does.
+         *
+         * @return The next name, or std::nullopt at the end of the list.
+         */
+        auto next() -> std::optional<std::string>;
+    };
+
+} // namespace ccwc::argument_parser
+
+#endif // CCWC_ARGUMENT_PARSER_FILE_LIST_READER_HPP
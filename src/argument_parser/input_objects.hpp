@@ -1,9 +1,7 @@
 #ifndef CCWC_ARGUMENT_PARSER_INPUT_OBJECTS_HPP
 #define CCWC_ARGUMENT_PARSER_INPUT_OBJECTS_HPP
 
-#include "algorithm/universal_input_stream.hpp"
-
-#include <memory>
+#include <cstring>
 #include <string>
 
 namespace ccwc::argument_parser
@@ -23,6 +21,11 @@ namespace ccwc::argument_parser
          */
         std::string mErrorMessage;
 
+        /**
+         * @brief The errno of a failed system call; the message is only built when printed.
+         */
+        int mErrno{0};
+
         /**
          * @brief Constructor for the HealthStatus class.
          */
@@ -37,20 +40,49 @@ namespace ccwc::argument_parser
             : mIsHealthy(isHealthy), mErrorMessage(std::move(errorMessage))
         {
         }
+
+        /**
+         * @brief Constructor for an input that failed with a system error.
+         * @param errorNumber The errno of the failed system call.
+         */
+        explicit HealthStatus(int errorNumber) : mIsHealthy(false), mErrno(errorNumber)
+        {
+        }
+
+        /**
+         * @brief The message to report for an unhealthy input.
+         * @param name The name of the input.
+         */
+        [[nodiscard]] auto describe(const std::string& name) const -> std::string
+        {
+            if (mErrno != 0)
+            {
+                return name + ": " + std::strerror(mErrno);
+            }
+            return mErrorMessage;
+        }
     };
 
     /**
      * @brief Input data object.
+     *
+     * This is a cheap description of an input; the input is only opened by the counting stage,
+     * right before it is counted, so large batches do not keep every file open.
      */
     struct InputDataObject
     {
         /**
-         * @brief The input stream.
+         * @brief The path of the input, or "<stdin>" for the standard input.
+         */
+        std::string mName;
+
+        /**
+         * @brief Whether the input is the standard input.
          */
-        std::unique_ptr<ccwc::algorithm::UniversalInputStream> mInputStream;
+        bool mIsStdin{false};
 
         /**
-         * @brief The health status of the input stream.
+         * @brief The health status of the input.
          */
         HealthStatus mHealthStatus;
     };
@@ -0,0 +1,52 @@
+#include "input_source.hpp"
+
+#include <utility>
+
+namespace ccwc::argument_parser
+{
+    InputSource::InputSource(std::vector<InputDataObject> operands)
+        : m_operands(std::move(operands))
+    {
+    }
+
+    InputSource::InputSource(FileListReader list) : m_list(std::move(list))
+    {
+    }
+
+    auto InputSource::hasSingleInput() const -> bool
+    {
+        return !m_list.has_value() && m_operands.size() <= 1;
+    }
+
+    auto InputSource::next() -> std::optional<InputDataObject>
+    {
+        if (!m_list.has_value())
+        {
+            if (m_next >= m_operands.size())
+            {
+                return std::nullopt;
+            }
+            return std::move(m_operands[m_next++]);
+        }
+
+        auto filename = m_list->next();
+        if (!filename.has_value())
+        {
+            return std::nullopt;
+        }
+        if (filename->empty())
+        {
+            return InputDataObject{"", false,
+                                   HealthStatus(false, "invalid zero-length file name")};
+        }
+        if (m_list->isStdin() && filename.value() == "-")
+        {
+            return InputDataObject{
+                "-", false,
+                HealthStatus(false, "when reading file names from stdin, no file name of "
+                                    "'-' allowed")};
+        }
+        return InputDataObject{std::move(filename.value()), false, HealthStatus(true, "")};
+    }
+
+} // namespace ccwc::argument_parser
@@ -0,0 +1,55 @@
+#ifndef CCWC_ARGUMENT_PARSER_INPUT_SOURCE_HPP
+#define CCWC_ARGUMENT_PARSER_INPUT_SOURCE_HPP
+
+#include "file_list_reader.hpp"
+#include "input_objects.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace ccwc::argument_parser
+{
+
+    /**
+     * @brief The inputs to count, handed out one at a time: the operands of the command line, or
+     * the names of a `--files0-from` / `--files-from` list as it is read.
+     *
+     * A list is never read ahead of the counting stage, so its names do not have to fit in
+     * memory; a name that cannot be used (empty, or "-" in a list read from stdin) is handed out
+     * as an unhealthy input so that it is reported in its place.
+     */
+    class InputSource
+    {
+      private:
+        std::vector<InputDataObject>  m_operands;
+        std::size_t                   m_next{0};
+        std::optional<FileListReader> m_list;
+
+      public:
+        /**
+         * @brief Constructor for the operands of the command line.
+         */
+        explicit InputSource(std::vector<InputDataObject> operands);
+
+        /**
+         * @brief Constructor for a file list.
+         */
+        explicit InputSource(FileListReader list);
+
+        /**
+         * @brief Whether there is at most one input, which is then not worth a thread.
+         */
+        [[nodiscard]] auto hasSingleInput() const -> bool;
+
+        /**
+         * @brief Take the next input.
+         * @return The input, or std::nullopt once every input was taken.
+         * @throws ccwc::exception::FileOperationException If the list cannot be read.
+         */
+        auto next() -> std::optional<InputDataObject>;
+    };
+
+} // namespace ccwc::argument_parser
+
+#endif // CCWC_ARGUMENT_PARSER_INPUT_SOURCE_HPP
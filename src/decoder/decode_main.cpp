@@ -0,0 +1,131 @@
+#include "algorithm/file_descriptor.hpp"
+#include "output_formatter/binary_report.hpp"
+#include "output_formatter/output_buffer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace detail
+{
+    /**
+     * @brief A whole file mapped into memory, or read into a buffer if it cannot be mapped.
+     */
+    class Report
+    {
+      private:
+        void*                      m_map{MAP_FAILED};
+        std::size_t                m_size{0};
+        std::vector<unsigned char> m_buffer;
+
+      public:
+        explicit Report(const char* path)
+        {
+            ccwc::algorithm::FileDescriptor fd(path != nullptr ? ::open(path, O_RDONLY)
+                                                               : ::dup(STDIN_FILENO));
+            struct stat status{};
+            if (fd.get() < 0 || ::fstat(fd.get(), &status) != 0)
+            {
+                throw std::runtime_error(std::string(path != nullptr ? path : "<stdin>") + ": " +
+                                         std::strerror(errno));
+            }
+
+            if (S_ISREG(status.st_mode) && status.st_size > 0)
+            {
+                m_size = static_cast<std::size_t>(status.st_size);
+                m_map  = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+            }
+            if (m_map != MAP_FAILED)
+            {
+                return;
+            }
+
+            constexpr std::size_t READ_SIZE = static_cast<std::size_t>(64 * 1024);
+            for (ssize_t got = 1; got > 0;)
+            {
+                std::size_t used = m_buffer.size();
+                m_buffer.resize(used + READ_SIZE);
+                got = ::read(fd.get(), m_buffer.data() + used, READ_SIZE);
+                if (got < 0 && errno == EINTR)
+                {
+                    got = 1;
+                }
+                m_buffer.resize(used + static_cast<std::size_t>(got > 0 ? got : 0));
+            }
+        }
+
+        ~Report()
+        {
+            if (m_map != MAP_FAILED)
+            {
+                ::munmap(m_map, m_size);
+            }
+        }
+
+        Report(const Report&)                    = delete;
+        auto operator=(const Report&) -> Report& = delete;
+        Report(Report&&)                         = delete;
+        auto operator=(Report&&) -> Report&      = delete;
+
+        [[nodiscard]] auto bytes() const -> std::span<const unsigned char>
+        {
+            if (m_map != MAP_FAILED)
+            {
+                return {static_cast<const unsigned char*>(m_map), m_size};
+            }
+            return m_buffer;
+        }
+    };
+} // namespace detail
+
+/**
+ * @brief Prints a `--format=binary` report of ccwc as tab-separated text.
+ *
+ * Usage: ccwc-decode [FILE]. A file is mmap()ed and its records are read in place; without
+ * one the report is read from the standard input.
+ */
+auto main(int argc, char** argv) noexcept -> int
+{
+    namespace binary_report = ccwc::output_formatter::binary_report;
+
+    try
+    {
+        std::span<char*> args(argv, static_cast<std::size_t>(argc));
+        detail::Report   report(args.size() > 1 ? args[1] : nullptr);
+
+        binary_report::Reader                reader(report.bytes());
+        ccwc::output_formatter::OutputBuffer out;
+        out.append("type\tname\tlines\twords\tchars\tbytes\tfiles\terrno\terror\n");
+        while (auto record = reader.next())
+        {
+            out.append(binary_report::recordTypeName(record->mType));
+            out.append('\t');
+            out.append(record->mName);
+            for (std::uint64_t value : {record->mLines, record->mWords, record->mChars,
+                                        record->mBytes, record->mFiles})
+            {
+                out.append('\t');
+                out.appendNumber(value);
+            }
+            out.append('\t');
+            out.appendNumber(record->mErrno);
+            out.append('\t');
+            out.append(record->mError);
+            out.append('\n');
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "ccwc-decode: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
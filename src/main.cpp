@@ -1,8 +1,16 @@
+#include "algorithm/file_follower.hpp"
+#include "algorithm/interval_counter.hpp"
 #include "algorithm/processor.hpp"
+#include "algorithm/row_selector.hpp"
+#include "algorithm/statistics.hpp"
+#include "algorithm/trace.hpp"
 #include "argument_parser/argument_parser.hpp"
 
 #include <iostream>
+#include <optional>
 #include <stdexcept>
+#include <unistd.h>
+#include <vector>
 
 auto main(int argc, char** argv) noexcept -> int
 {
@@ -10,10 +18,183 @@ auto main(int argc, char** argv) noexcept -> int
     try
     {
         auto args = ccwc::parseArguments(argc, argv);
+        if (args.tracePath().has_value())
+        {
+            // Before any thread is started, so every thread sees it on.
+            ccwc::algorithm::enableTracing();
+        }
 
-        auto counters = ccwc::algorithm::doCount(args.inputDataObjects());
+        auto inputs = args.takeInputs();
+        if (args.isFollowing())
+        {
+            // Every followed file is watched until the end, so a file list is read as a whole.
+            std::vector<ccwc::argument_parser::InputDataObject> followed;
+            while (auto input = inputs.next())
+            {
+                followed.push_back(std::move(input.value()));
+            }
+            ccwc::algorithm::FileFollower follower(
+                followed, args.interval().value_or(ccwc::algorithm::DEFAULT_FOLLOW_INTERVAL));
+            follower.run([&args](const ccwc::algorithm::ResultStore& results) {
+                args.formatOutput(results);
+            });
+        }
 
-        args.formatOutput(counters);
+        // Grouped counts are accumulated while counting instead of keeping a row per file.
+        std::optional<ccwc::algorithm::CounterGroups> groups;
+        if (args.isGrouped())
+        {
+            groups.emplace(args.groupingOptions());
+        }
+        ccwc::algorithm::CounterGroups* groupSink = groups.has_value() ? &groups.value() : nullptr;
+
+        std::optional<ccwc::algorithm::ResultCache> cache;
+        if (args.cacheDirectory().has_value())
+        {
+            cache.emplace(args.cacheDirectory().value());
+        }
+        ccwc::algorithm::ResultCache* resultCache = cache.has_value() ? &cache.value() : nullptr;
+
+        std::optional<ccwc::algorithm::StatisticsRecorder> statistics;
+        if (args.showsStats() || args.showsPerfCounters())
+        {
+            statistics.emplace(args.showsStats(), args.showsPerfCounters());
+        }
+        ccwc::algorithm::StatisticsRecorder* stats =
+            statistics.has_value() ? &statistics.value() : nullptr;
+
+        // Sizes are only known up front for plain files on the command line that are counted as
+        // they are.
+        bool plainFiles = !args.readsFileList() && !args.isArchiveMode() && !args.isRecursive() &&
+                          args.inputStreamOptions().mDecompress ==
+                              ccwc::algorithm::CompressionFormat::NONE;
+        ccwc::algorithm::InputSizes sizes;
+        if (plainFiles)
+        {
+            sizes = ccwc::algorithm::inputSizes(args.inputDataObjects());
+        }
+        // Without every size known (a FIFO, a device) there is nothing to give a share of.
+        ccwc::algorithm::ProgressTracker progress(plainFiles ? args.inputDataObjects().size() : 0,
+                                                  sizes.mAllKnown ? sizes.mBytes : 0);
+
+        // Rows are printed as soon as they are counted if their width is known up front: the
+        // summed sizes of regular files bound every column, as long as none of them grows.
+        std::optional<std::size_t> rowWidth = args.width();
+        if (!rowWidth.has_value() && plainFiles && sizes.mAllKnown && sizes.mSettled)
+        {
+            rowWidth = ccwc::output_formatter::digitCount(sizes.mBytes);
+        }
+        // With --total=only the inputs are summed up as they are counted and only failures are
+        // printed, so nothing is kept per input and no width is needed before the total.
+        bool streamRows = args.canStreamRows() && (rowWidth.has_value() || args.isTotalOnly());
+
+        // Started before any counting thread, so the signals it waits for are blocked in all.
+        std::optional<ccwc::algorithm::ProgressMonitor> monitor;
+        if (!args.isIntervalReporting())
+        {
+            monitor.emplace(progress, args.showsProgress(),
+                            [&args](const ccwc::algorithm::Counter& partial) {
+                                args.formatPartial(partial);
+                            });
+        }
+
+        ccwc::algorithm::ResultStore results;
+
+        // With --top, --sort-by or --min-* the rows are selected as the inputs are counted.
+        std::optional<ccwc::algorithm::RowSelector> selector;
+        ccwc::algorithm::CountedCallback            onCounted;
+        if (args.isSelecting() && !args.isIntervalReporting())
+        {
+            selector.emplace(args.selectionOptions(), args.isRecursive());
+            onCounted = [&selector](std::size_t                                   index,
+                                    const ccwc::argument_parser::InputDataObject& input,
+                                    const ccwc::algorithm::Counter&               counter) {
+                selector->add(index, input, counter);
+            };
+        }
+
+        auto count = [&](const ccwc::algorithm::CountedCallback& counted) {
+            if (args.isArchiveMode())
+            {
+                return ccwc::algorithm::doCountArchives(inputs, args.inputStreamOptions(),
+                                                        groupSink, &progress, counted, stats);
+            }
+            if (args.isRecursive())
+            {
+                return ccwc::algorithm::doCountRecursive(inputs, args.inputStreamOptions(),
+                                                         args.walkOptions(), groupSink,
+                                                         resultCache, &progress, counted, stats);
+            }
+            return ccwc::algorithm::doCount(inputs, args.inputStreamOptions(), groupSink,
+                                            resultCache, &progress, counted, stats);
+        };
+
+        if (args.isIntervalReporting())
+        {
+            args.formatHeader();
+            auto input = inputs.next().value();
+            results.add(input, ccwc::algorithm::countWithIntervals(
+                                   STDIN_FILENO, input.mName, args.interval().value(),
+                                   [&args](const ccwc::algorithm::Counter& delta,
+                                           const ccwc::algorithm::Counter& total) {
+                                       args.formatInterval(delta, total);
+                                   }));
+        }
+        else if (streamRows)
+        {
+            auto report = args.streamingReport(rowWidth.value_or(0));
+            count([&report](std::size_t index, const ccwc::argument_parser::InputDataObject& input,
+                            const ccwc::algorithm::Counter& counter) {
+                report.add(index, input, counter);
+            });
+            report.finish();
+        }
+        else
+        {
+            results = count(onCounted);
+        }
+        monitor.reset();
+
+        ccwc::algorithm::PerfCounters* perf =
+            statistics.has_value() ? statistics->perfCounters() : nullptr;
+        ccwc::algorithm::PerfSample formatStart;
+        if (perf != nullptr)
+        {
+            formatStart = perf->sample();
+        }
+        {
+            ccwc::algorithm::TraceSpan span("format");
+            if (groups.has_value())
+            {
+                args.formatOutput(results, groups.value());
+            }
+            else if (selector.has_value())
+            {
+                args.formatOutput(selector->finish());
+            }
+            else if (!streamRows)
+            {
+                args.formatOutput(results);
+            }
+            std::cout.flush();
+        }
+        if (perf != nullptr)
+        {
+            perf->add("format", formatStart, statistics->bytes());
+        }
+
+        if (args.showsStats())
+        {
+            std::cerr << statistics->summary();
+        }
+        if (perf != nullptr)
+        {
+            std::cerr << perf->report();
+        }
+        if (args.tracePath().has_value())
+        {
+            ccwc::algorithm::writeTrace(args.tracePath().value());
+        }
     }
     catch (std::exception& e)
     {
@@ -0,0 +1,180 @@
+#include "binary_report.hpp"
+
+#include "exception/exception.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace ccwc::output_formatter::binary_report
+{
+    namespace detail
+    {
+        constexpr unsigned BYTE_BITS{8};
+        constexpr unsigned BYTE_MASK{0xff};
+
+        /**
+         * @brief Append an unsigned integer in little-endian byte order.
+         */
+        template <typename Integer>
+        auto appendLittleEndian(OutputBuffer& out, Integer value) -> void
+        {
+            std::array<char, sizeof(Integer)> bytes{};
+            for (char& byte : bytes)
+            {
+                byte = static_cast<char>(value & BYTE_MASK);
+                value >>= BYTE_BITS;
+            }
+            out.append(std::string_view(bytes.data(), bytes.size()));
+        }
+
+        /**
+         * @brief Read an unsigned integer in little-endian byte order.
+         */
+        template <typename Integer>
+        auto readLittleEndian(std::span<const unsigned char> data, std::size_t offset) -> Integer
+        {
+            Integer value{0};
+            for (std::size_t i = sizeof(Integer); i > 0; --i)
+            {
+                value = static_cast<Integer>(value << BYTE_BITS) | data[offset + i - 1];
+            }
+            return value;
+        }
+
+        auto malformed(std::size_t offset, const std::string& what)
+            -> ccwc::exception::FileOperationException
+        {
+            return ccwc::exception::FileOperationException(
+                "malformed binary report at offset " + std::to_string(offset) + ": " + what);
+        }
+    } // namespace detail
+
+    auto recordTypeName(RecordType type) -> std::string_view
+    {
+        switch (type)
+        {
+        case RecordType::FILE:
+            return "file";
+        case RecordType::DIRECTORY:
+            return "directory";
+        case RecordType::GROUP:
+            return "group";
+        case RecordType::TOTAL:
+            return "total";
+        case RecordType::DELTA:
+            return "delta";
+        case RecordType::INTERRUPTED:
+            return "interrupted";
+        case RecordType::ERROR:
+            return "error";
+        }
+        return "unknown";
+    }
+
+    auto appendHeader(OutputBuffer& out, const Header& header) -> void
+    {
+        out.append(std::string_view(MAGIC.data(), MAGIC.size()));
+        detail::appendLittleEndian(out, header.mVersion);
+        detail::appendLittleEndian(out, header.mRecordFixedSize);
+        detail::appendLittleEndian(out, header.mColumns);
+    }
+
+    auto appendRecord(OutputBuffer& out, const Record& record) -> void
+    {
+        std::size_t size    = RECORD_FIXED_SIZE + record.mName.size() + record.mError.size();
+        std::size_t padding = (RECORD_ALIGNMENT - size % RECORD_ALIGNMENT) % RECORD_ALIGNMENT;
+
+        detail::appendLittleEndian(out, static_cast<std::uint32_t>(size + padding));
+        detail::appendLittleEndian(out, static_cast<std::uint16_t>(record.mType));
+        detail::appendLittleEndian(out, std::uint16_t{0});
+        detail::appendLittleEndian(out, record.mErrno);
+        detail::appendLittleEndian(out, static_cast<std::uint32_t>(record.mName.size()));
+        detail::appendLittleEndian(out, static_cast<std::uint32_t>(record.mError.size()));
+        detail::appendLittleEndian(out, std::uint32_t{0});
+        detail::appendLittleEndian(out, record.mLines);
+        detail::appendLittleEndian(out, record.mWords);
+        detail::appendLittleEndian(out, record.mChars);
+        detail::appendLittleEndian(out, record.mBytes);
+        detail::appendLittleEndian(out, record.mFiles);
+        out.append(record.mName);
+        out.append(record.mError);
+        out.append(std::string_view("\0\0\0\0\0\0\0", padding));
+    }
+
+    Reader::Reader(std::span<const unsigned char> data) : m_data(data)
+    {
+        if (!readHeader())
+        {
+            throw detail::malformed(0, "no header");
+        }
+    }
+
+    auto Reader::readHeader() -> bool
+    {
+        if (m_data.size() - m_offset < HEADER_SIZE ||
+            !std::equal(MAGIC.begin(), MAGIC.end(), m_data.subspan(m_offset).begin(),
+                        [](char magic, unsigned char byte) {
+                            return static_cast<unsigned char>(magic) == byte;
+                        }))
+        {
+            return false;
+        }
+
+        m_header.mVersion         = detail::readLittleEndian<std::uint16_t>(m_data, m_offset + 8);
+        m_header.mRecordFixedSize = detail::readLittleEndian<std::uint16_t>(m_data, m_offset + 10);
+        m_header.mColumns         = detail::readLittleEndian<std::uint32_t>(m_data, m_offset + 12);
+        if (m_header.mVersion != VERSION || m_header.mRecordFixedSize < RECORD_FIXED_SIZE)
+        {
+            throw detail::malformed(m_offset, "unsupported version");
+        }
+        m_offset += HEADER_SIZE;
+        return true;
+    }
+
+    auto Reader::next() -> std::optional<Record>
+    {
+        while (readHeader())
+        {
+            // the report was printed again
+        }
+        if (m_offset == m_data.size())
+        {
+            return std::nullopt;
+        }
+        if (m_data.size() - m_offset < m_header.mRecordFixedSize)
+        {
+            throw detail::malformed(m_offset, "truncated record");
+        }
+
+        auto field = [this](auto type, std::size_t offset) {
+            return detail::readLittleEndian<decltype(type)>(m_data, m_offset + offset);
+        };
+
+        std::size_t   size        = field(std::uint32_t{}, 0);
+        std::uint32_t nameSize    = field(std::uint32_t{}, 12);
+        std::uint32_t errorSize   = field(std::uint32_t{}, 16);
+        std::size_t   stringsSize = static_cast<std::size_t>(nameSize) + errorSize;
+        if (size > m_data.size() - m_offset || size < m_header.mRecordFixedSize + stringsSize)
+        {
+            throw detail::malformed(m_offset, "bad record size");
+        }
+
+        Record record;
+        record.mType  = static_cast<RecordType>(field(std::uint16_t{}, 4));
+        record.mErrno = field(std::uint32_t{}, 8);
+        record.mLines = field(std::uint64_t{}, 24);
+        record.mWords = field(std::uint64_t{}, 32);
+        record.mChars = field(std::uint64_t{}, 40);
+        record.mBytes = field(std::uint64_t{}, 48);
+        record.mFiles = field(std::uint64_t{}, 56);
+
+        const auto* strings = reinterpret_cast<const char*>( // NOLINT(*-reinterpret-cast)
+            m_data.data() + m_offset + m_header.mRecordFixedSize);
+        record.mName  = std::string_view(strings, nameSize);
+        record.mError = std::string_view(strings + nameSize, errorSize); // NOLINT(*-arithmetic)
+
+        m_offset += size;
+        return record;
+    }
+
+} // namespace ccwc::output_formatter::binary_report
@@ -0,0 +1,155 @@
+#ifndef CCWC_BINARY_REPORT_HPP
+#define CCWC_BINARY_REPORT_HPP
+
+#include "output_buffer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+/**
+ * @brief The `--format=binary` report: a header followed by length-prefixed records.
+ *
+ * Every integer is little-endian. The stream starts with a 16 byte header:
+ *
+ *     offset size
+ *          0    8  magic "CCWCBIN\0"
+ *          8    2  version, 1
+ *         10    2  size of the fixed part of a record, 64
+ *         12    4  columns that were asked for: 1 lines, 2 words, 4 chars, 8 bytes
+ *
+ * and is followed by records, each padded to a multiple of 8 bytes so the counts of a report
+ * that is mmap()ed are aligned:
+ *
+ *     offset size
+ *          0    4  size of the record, padding included
+ *          4    2  type, see RecordType
+ *          6    2  reserved, 0
+ *          8    4  errno of an error record, 0 if there is none or the error has no errno
+ *         12    4  length of the name
+ *         16    4  length of the error message
+ *         20    4  reserved, 0
+ *         24    8  lines
+ *         32    8  words
+ *         40    8  chars
+ *         48    8  bytes
+ *         56    8  files of a group or a group total, 0 otherwise
+ *         64       name, then error message, then padding
+ *
+ * Readers skip a record by its size and must ignore what lies past the fields they know, so
+ * later versions can grow the fixed part. A report that is printed more than once, as with
+ * `--follow`, repeats the header before each report.
+ */
+namespace ccwc::output_formatter::binary_report
+{
+
+    constexpr std::array<char, 8> MAGIC{'C', 'C', 'W', 'C', 'B', 'I', 'N', '\0'};
+    constexpr std::uint16_t       VERSION{1};
+    constexpr std::size_t         HEADER_SIZE{16};
+    constexpr std::size_t         RECORD_FIXED_SIZE{64};
+    constexpr std::size_t         RECORD_ALIGNMENT{8};
+
+    constexpr std::uint32_t COLUMN_LINES{1};
+    constexpr std::uint32_t COLUMN_WORDS{2};
+    constexpr std::uint32_t COLUMN_CHARS{4};
+    constexpr std::uint32_t COLUMN_BYTES{8};
+
+    /**
+     * @brief What a record describes; the values are part of the format.
+     */
+    enum class RecordType : std::uint16_t
+    {
+        FILE        = 1,
+        DIRECTORY   = 2,
+        GROUP       = 3,
+        TOTAL       = 4,
+        DELTA       = 5, // What a rolling report counted since the previous one.
+        INTERRUPTED = 6, // The totals of a count stopped by SIGINT.
+        ERROR       = 7,
+    };
+
+    /**
+     * @brief The name of a record type, as used by the text-based structured formats.
+     */
+    auto recordTypeName(RecordType type) -> std::string_view;
+
+    /**
+     * @brief The header of a report.
+     */
+    struct Header
+    {
+        std::uint16_t mVersion{VERSION};
+        std::uint16_t mRecordFixedSize{RECORD_FIXED_SIZE};
+        std::uint32_t mColumns{0};
+    };
+
+    /**
+     * @brief One record; the name and the message point into the buffer it was read from.
+     */
+    struct Record
+    {
+        RecordType       mType{RecordType::FILE};
+        std::uint32_t    mErrno{0};
+        std::uint64_t    mLines{0};
+        std::uint64_t    mWords{0};
+        std::uint64_t    mChars{0};
+        std::uint64_t    mBytes{0};
+        std::uint64_t    mFiles{0};
+        std::string_view mName;
+        std::string_view mError;
+    };
+
+    /**
+     * @brief Append the header of a report.
+     */
+    auto appendHeader(OutputBuffer& out, const Header& header) -> void;
+
+    /**
+     * @brief Append a record.
+     */
+    auto appendRecord(OutputBuffer& out, const Record& record) -> void;
+
+    /**
+     * @brief Reads the records of a report held in memory, e.g. an mmap()ed file.
+     */
+    class Reader
+    {
+      private:
+        std::span<const unsigned char> m_data;
+        std::size_t                    m_offset{0};
+        Header                         m_header;
+
+        /**
+         * @brief Read a header at the current offset if there is one.
+         */
+        auto readHeader() -> bool;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param data The report; it must outlive the records read from it.
+         * @throws FileOperationException if the report does not start with a header.
+         */
+        explicit Reader(std::span<const unsigned char> data);
+
+        /**
+         * @brief The header of the report being read.
+         */
+        [[nodiscard]] auto header() const -> const Header&
+        {
+            return m_header;
+        }
+
+        /**
+         * @brief The next record, std::nullopt at the end of the report.
+         * @throws FileOperationException if a record is truncated or malformed.
+         */
+        auto next() -> std::optional<Record>;
+    };
+
+} // namespace ccwc::output_formatter::binary_report
+
+#endif // CCWC_BINARY_REPORT_HPP
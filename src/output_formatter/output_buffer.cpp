@@ -0,0 +1,98 @@
+#include "output_buffer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+namespace ccwc::output_formatter
+{
+    namespace detail
+    {
+        constexpr std::size_t   OUTPUT_BUFFER_SIZE = static_cast<std::size_t>(64 * 1024); // 64KiB
+        constexpr std::size_t   MAX_DIGITS         = 20; // of a std::uint64_t
+        constexpr std::uint64_t DECIMAL_BASE       = 10;
+    } // namespace detail
+
+    OutputBuffer::OutputBuffer(int fd) : m_fd(fd), m_data(detail::OUTPUT_BUFFER_SIZE)
+    {
+    }
+
+    OutputBuffer::~OutputBuffer()
+    {
+        flush();
+    }
+
+    auto OutputBuffer::reserve(std::size_t size) -> void
+    {
+        if (m_used + size > m_data.size())
+        {
+            flush();
+        }
+    }
+
+    auto OutputBuffer::append(std::string_view text) -> void
+    {
+        while (!text.empty())
+        {
+            reserve(std::min(text.size(), m_data.size()));
+            std::size_t chunk = std::min(text.size(), m_data.size() - m_used);
+            std::memcpy(m_data.data() + m_used, text.data(), chunk);
+            m_used += chunk;
+            text.remove_prefix(chunk);
+        }
+    }
+
+    auto OutputBuffer::append(char character) -> void
+    {
+        reserve(1);
+        m_data[m_used++] = character;
+    }
+
+    auto OutputBuffer::appendNumber(std::uint64_t value, std::size_t width) -> void
+    {
+        std::size_t digits = digitCount(value);
+        if (width > digits)
+        {
+            reserve(width - digits);
+            std::fill_n(m_data.begin() + static_cast<std::ptrdiff_t>(m_used), width - digits, ' ');
+            m_used += width - digits;
+        }
+        reserve(detail::MAX_DIGITS);
+        char* first  = m_data.data() + m_used;
+        auto  result = std::to_chars(first, first + detail::MAX_DIGITS, value);
+        m_used += static_cast<std::size_t>(result.ptr - first);
+    }
+
+    auto OutputBuffer::flush() -> void
+    {
+        const char* data = m_data.data();
+        std::size_t size = m_used;
+        while (size > 0)
+        {
+            ssize_t written = ::write(m_fd, data, size);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                break; // nowhere to report to, e.g. a closed pipe
+            }
+            data += written; // NOLINT(*-pointer-arithmetic)
+            size -= static_cast<std::size_t>(written);
+        }
+        m_used = 0;
+    }
+
+    auto digitCount(std::uint64_t value) -> std::size_t
+    {
+        std::size_t digits{1};
+        for (; value >= detail::DECIMAL_BASE; value /= detail::DECIMAL_BASE)
+        {
+            ++digits;
+        }
+        return digits;
+    }
+
+} // namespace ccwc::output_formatter
@@ -0,0 +1,77 @@
+#ifndef CCWC_OUTPUT_BUFFER_HPP
+#define CCWC_OUTPUT_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+namespace ccwc::output_formatter
+{
+
+    /**
+     * @brief Fixed-size output buffer written to a file descriptor with large write(2) calls.
+     *
+     * Rows are appended piece by piece and numbers are converted in place with std::to_chars,
+     * so formatting a row allocates nothing. The buffer is written out when it fills up, on
+     * flush() and when it is destroyed.
+     */
+    class OutputBuffer
+    {
+      private:
+        int               m_fd;
+        std::vector<char> m_data;
+        std::size_t       m_used{0};
+
+        /**
+         * @brief Make room for `size` more bytes, writing the buffer out if needed.
+         */
+        auto reserve(std::size_t size) -> void;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param fd The descriptor written to; it is not closed.
+         */
+        explicit OutputBuffer(int fd = STDOUT_FILENO);
+
+        /**
+         * @brief Destructor: writes out what is left.
+         */
+        ~OutputBuffer();
+
+        OutputBuffer(const OutputBuffer&)                    = delete;
+        auto operator=(const OutputBuffer&) -> OutputBuffer& = delete;
+        OutputBuffer(OutputBuffer&&)                         = delete;
+        auto operator=(OutputBuffer&&) -> OutputBuffer&      = delete;
+
+        /**
+         * @brief Append text.
+         */
+        auto append(std::string_view text) -> void;
+
+        /**
+         * @brief Append a single character.
+         */
+        auto append(char character) -> void;
+
+        /**
+         * @brief Append a number right-aligned in a field of `width` characters.
+         */
+        auto appendNumber(std::uint64_t value, std::size_t width = 0) -> void;
+
+        /**
+         * @brief Write the buffered bytes out.
+         */
+        auto flush() -> void;
+    };
+
+    /**
+     * @brief Number of decimal digits of a value.
+     */
+    auto digitCount(std::uint64_t value) -> std::size_t;
+
+} // namespace ccwc::output_formatter
+
+#endif // CCWC_OUTPUT_BUFFER_HPP
@@ -1,162 +1,798 @@
 #include "output_formatter.hpp"
 
 #include <cstddef>
+#include <functional>
+#include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace ccwc::output_format_options
 {
-    class LinesFormatHandler : public FormatHandler
+    auto parseTotalMode(std::string_view name) -> std::optional<TotalMode>
     {
+        if (name == "auto")
+        {
+            return TotalMode::AUTO;
+        }
+        if (name == "always")
+        {
+            return TotalMode::ALWAYS;
+        }
+        if (name == "only")
+        {
+            return TotalMode::ONLY;
+        }
+        if (name == "never")
+        {
+            return TotalMode::NEVER;
+        }
+        return std::nullopt;
+    }
+
+    auto parseReportFormat(std::string_view name) -> std::optional<ReportFormat>
+    {
+        if (name == "text")
+        {
+            return ReportFormat::TEXT;
+        }
+        if (name == "ndjson" || name == "jsonl")
+        {
+            return ReportFormat::NDJSON;
+        }
+        if (name == "csv")
+        {
+            return ReportFormat::CSV;
+        }
+        if (name == "tsv")
+        {
+            return ReportFormat::TSV;
+        }
+        if (name == "binary")
+        {
+            return ReportFormat::BINARY;
+        }
+        return std::nullopt;
+    }
+} // namespace ccwc::output_format_options
+
+namespace ccwc::output_formatter
+{
+    namespace detail
+    {
+        /**
+         * @brief Call `visit(directory)` for the root of `path` and every directory between it
+         * and the file, up to `maxDepth` components below the root.
+         *
+         * Depth is counted from the root the way `du --max-depth` does: the root (its first
+         * `rootLength` characters, "." if there are none) is depth 0, a directory right below it
+         * depth 1. Directories above the root are never visited.
+         */
+        template <typename Visitor>
+        auto forEachDirectory(std::string_view path, std::size_t rootLength, std::size_t maxDepth,
+                              Visitor&& visit) -> void
+        {
+            std::string_view root = path.substr(0, rootLength);
+            while (root.size() > 1 && root.ends_with('/'))
+            {
+                root.remove_suffix(1);
+            }
+            visit(root.empty() ? std::string_view(".") : root);
+
+            // The root is separated from the rest by '/', or by ':' for an archive member.
+            std::size_t start = rootLength;
+            if (start > 0 && start < path.size() && (path[start] == '/' || path[start] == ':'))
+            {
+                ++start;
+            }
+            std::size_t depth{0};
+            for (std::size_t slash = path.find('/', start); slash != std::string_view::npos;
+                 slash = path.find('/', slash + 1))
+            {
+                if (++depth > maxDepth)
+                {
+                    return;
+                }
+                visit(path.substr(0, slash));
+            }
+        }
+
+        /**
+         * @brief The value of one column of a counter.
+         */
+        auto columnValue(const ccwc::algorithm::Counter&                  counter,
+                         ccwc::output_format_options::OutputFormatOptions option) -> std::uint64_t
+        {
+            using ccwc::output_format_options::OutputFormatOptions;
+
+            switch (option)
+            {
+            case OutputFormatOptions::FORMAT_LINES:
+                return counter.lines;
+            case OutputFormatOptions::FORMAT_WORDS:
+                return counter.words;
+            case OutputFormatOptions::FORMAT_MULTIBYTE:
+                return counter.multibyte;
+            case OutputFormatOptions::FORMAT_BYTES:
+                return counter.bytes;
+            }
+            return 0;
+        }
+
+        /**
+         * @brief The name of a column in the header and the keys of structured reports.
+         */
+        auto columnName(ccwc::output_format_options::OutputFormatOptions option)
+            -> std::string_view
+        {
+            using ccwc::output_format_options::OutputFormatOptions;
+
+            switch (option)
+            {
+            case OutputFormatOptions::FORMAT_LINES:
+                return "lines";
+            case OutputFormatOptions::FORMAT_WORDS:
+                return "words";
+            case OutputFormatOptions::FORMAT_MULTIBYTE:
+                return "chars";
+            case OutputFormatOptions::FORMAT_BYTES:
+                return "bytes";
+            }
+            return "";
+        }
+
+        /**
+         * @brief The bit of a column in the header of a binary report.
+         */
+        auto columnBit(ccwc::output_format_options::OutputFormatOptions option) -> std::uint32_t
+        {
+            using ccwc::output_format_options::OutputFormatOptions;
+
+            switch (option)
+            {
+            case OutputFormatOptions::FORMAT_LINES:
+                return binary_report::COLUMN_LINES;
+            case OutputFormatOptions::FORMAT_WORDS:
+                return binary_report::COLUMN_WORDS;
+            case OutputFormatOptions::FORMAT_MULTIBYTE:
+                return binary_report::COLUMN_CHARS;
+            case OutputFormatOptions::FORMAT_BYTES:
+                return binary_report::COLUMN_BYTES;
+            }
+            return 0;
+        }
+
+        /**
+         * @brief The name of an input in structured reports; the standard input has none.
+         */
+        auto recordName(std::string_view name, bool isStdin) -> std::optional<std::string_view>
+        {
+            if (isStdin)
+            {
+                return std::nullopt;
+            }
+            return name;
+        }
 
-      protected:
-        auto handle(const ccwc::algorithm::Counter& counter) -> std::string override
+        /**
+         * @brief The message of an input that failed.
+         */
+        auto errorMessage(std::string_view name, const ccwc::argument_parser::HealthStatus& health)
+            -> std::string
         {
-            return std::to_string(counter.lines);
+            return health.describe(std::string(name));
         }
 
-      public:
-        explicit LinesFormatHandler(std::size_t max_length, bool enabled)
-            : FormatHandler(max_length, enabled)
+        /**
+         * @brief Append a JSON string. Control characters, quotes and backslashes are escaped;
+         * other bytes are copied as they are, so names that are not UTF-8 stay byte-exact.
+         */
+        auto appendJsonString(OutputBuffer& out, std::string_view text) -> void
         {
+            constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+            constexpr unsigned char    FIRST_PRINTABLE{0x20};
+            constexpr unsigned         NIBBLE_BITS{4};
+            constexpr unsigned         NIBBLE_MASK{0xf};
+
+            out.append('"');
+            std::size_t start{0};
+            for (std::size_t i = 0; i < text.size(); ++i)
+            {
+                auto byte = static_cast<unsigned char>(text[i]);
+                if (byte >= FIRST_PRINTABLE && byte != '"' && byte != '\\')
+                {
+                    continue;
+                }
+                out.append(text.substr(start, i - start));
+                start = i + 1;
+                out.append('\\');
+                switch (byte)
+                {
+                case '"':
+                case '\\':
+                    out.append(static_cast<char>(byte));
+                    break;
+                case '\n':
+                    out.append('n');
+                    break;
+                case '\t':
+                    out.append('t');
+                    break;
+                case '\r':
+                    out.append('r');
+                    break;
+                default:
+                    out.append("u00");
+                    out.append(HEX_DIGITS[byte >> NIBBLE_BITS]);
+                    out.append(HEX_DIGITS[byte & NIBBLE_MASK]);
+                    break;
+                }
+            }
+            out.append(text.substr(start));
+            out.append('"');
+        }
+
+        /**
+         * @brief Append a CSV field, quoted only if it has to be.
+         */
+        auto appendCsvField(OutputBuffer& out, std::string_view text) -> void
+        {
+            if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+            {
+                out.append(text);
+                return;
+            }
+            out.append('"');
+            for (std::size_t quote = text.find('"'); quote != std::string_view::npos;
+                 quote          = text.find('"'))
+            {
+                out.append(text.substr(0, quote + 1));
+                out.append('"');
+                text.remove_prefix(quote + 1);
+            }
+            out.append(text);
+            out.append('"');
+        }
+
+        /**
+         * @brief Append a TSV field, with backslash escapes for the characters that would break
+         * the row.
+         */
+        auto appendTsvField(OutputBuffer& out, std::string_view text) -> void
+        {
+            for (char character : text)
+            {
+                switch (character)
+                {
+                case '\\':
+                    out.append("\\\\");
+                    break;
+                case '\t':
+                    out.append("\\t");
+                    break;
+                case '\n':
+                    out.append("\\n");
+                    break;
+                case '\r':
+                    out.append("\\r");
+                    break;
+                default:
+                    out.append(character);
+                    break;
+                }
+            }
         }
-    };
+    } // namespace detail
 
-    class WordsFormatHandler : public FormatHandler
+    auto OutputFormatter::addOption(ccwc::output_format_options::OutputFormatOptions option) -> void
+    {
+        this->m_format_options.insert(option);
+    }
+
+    auto OutputFormatter::setWidth(std::size_t width) -> void
+    {
+        m_width = width;
+    }
+
+    auto OutputFormatter::width() const -> const std::optional<std::size_t>&
     {
-      protected:
-        auto handle(const ccwc::algorithm::Counter& counter) -> std::string override
+        return m_width;
+    }
+
+    auto OutputFormatter::setReportFormat(ccwc::output_format_options::ReportFormat format) -> void
+    {
+        m_report_format = format;
+    }
+
+    auto OutputFormatter::isStructured() const -> bool
+    {
+        return m_report_format != ccwc::output_format_options::ReportFormat::TEXT;
+    }
+
+    auto OutputFormatter::setTotalMode(ccwc::output_format_options::TotalMode mode) -> void
+    {
+        m_total_mode = mode;
+    }
+
+    auto OutputFormatter::totalMode() const -> ccwc::output_format_options::TotalMode
+    {
+        return m_total_mode;
+    }
+
+    auto OutputFormatter::printsTotal(std::size_t rows) const -> bool
+    {
+        using ccwc::output_format_options::TotalMode;
+
+        switch (m_total_mode)
         {
-            return std::to_string(counter.words);
+        case TotalMode::AUTO:
+            return isStructured() || rows > static_cast<std::size_t>(1);
+        case TotalMode::ALWAYS:
+        case TotalMode::ONLY:
+            return true;
+        case TotalMode::NEVER:
+            return false;
         }
+        return false;
+    }
 
-      public:
-        explicit WordsFormatHandler(std::size_t max_length, bool enabled)
-            : FormatHandler(max_length, enabled)
+    auto OutputFormatter::columnWidth(std::uint64_t largest) const -> std::size_t
+    {
+        return m_width.value_or(digitCount(largest));
+    }
+
+    auto OutputFormatter::writeColumns(OutputBuffer& out, const ccwc::algorithm::Counter& counter,
+                                       std::size_t width) const -> void
+    {
+        // m_format_options is ordered like the columns.
+        for (auto option : m_format_options)
+        {
+            out.appendNumber(detail::columnValue(counter, option), width + 2);
+        }
+    }
+
+    auto OutputFormatter::writeHeader(OutputBuffer& out, bool withFiles) const -> void
+    {
+        using ccwc::output_format_options::ReportFormat;
+
+        if (m_report_format == ReportFormat::BINARY)
+        {
+            binary_report::Header header;
+            for (auto option : m_format_options)
+            {
+                header.mColumns |= detail::columnBit(option);
+            }
+            binary_report::appendHeader(out, header);
+            return;
+        }
+        if (m_report_format != ReportFormat::CSV && m_report_format != ReportFormat::TSV)
+        {
+            return;
+        }
+        char separator = m_report_format == ReportFormat::CSV ? ',' : '\t';
+
+        out.append("type");
+        out.append(separator);
+        out.append("name");
+        for (auto option : m_format_options)
+        {
+            out.append(separator);
+            out.append(detail::columnName(option));
+        }
+        if (withFiles)
         {
+            out.append(separator);
+            out.append("files");
         }
-    };
+        out.append(separator);
+        out.append("error\n");
+    }
 
-    class MultibyteFormatHandler : public FormatHandler
+    auto OutputFormatter::writeRecord(OutputBuffer& out, binary_report::RecordType type,
+                                      std::optional<std::string_view> name,
+                                      const ccwc::algorithm::Counter& counter,
+                                      std::optional<std::uint64_t>    files) const -> void
     {
-      protected:
-        auto handle(const ccwc::algorithm::Counter& counter) -> std::string override
+        using ccwc::output_format_options::ReportFormat;
+
+        if (m_report_format == ReportFormat::BINARY)
         {
-            return std::to_string(counter.multibyte);
+            binary_report::Record record;
+            record.mType  = type;
+            record.mLines = counter.lines;
+            record.mWords = counter.words;
+            record.mChars = counter.multibyte;
+            record.mBytes = counter.bytes;
+            record.mFiles = files.value_or(0);
+            record.mName  = name.value_or(std::string_view());
+            binary_report::appendRecord(out, record);
+            return;
         }
 
-      public:
-        explicit MultibyteFormatHandler(std::size_t max_length, bool enabled)
-            : FormatHandler(max_length, enabled)
+        if (m_report_format == ReportFormat::NDJSON)
+        {
+            out.append(R"({"type":")");
+            out.append(binary_report::recordTypeName(type));
+            out.append('"');
+            if (name.has_value())
+            {
+                out.append(R"(,"name":)");
+                detail::appendJsonString(out, name.value());
+            }
+            for (auto option : m_format_options)
+            {
+                out.append(",\"");
+                out.append(detail::columnName(option));
+                out.append("\":");
+                out.appendNumber(detail::columnValue(counter, option));
+            }
+            if (files.has_value())
+            {
+                out.append(R"(,"files":)");
+                out.appendNumber(files.value());
+            }
+            out.append("}\n");
+            return;
+        }
+
+        bool csv       = m_report_format == ReportFormat::CSV;
+        char separator = csv ? ',' : '\t';
+
+        out.append(binary_report::recordTypeName(type));
+        out.append(separator);
+        if (name.has_value())
+        {
+            csv ? detail::appendCsvField(out, name.value())
+                : detail::appendTsvField(out, name.value());
+        }
+        for (auto option : m_format_options)
+        {
+            out.append(separator);
+            out.appendNumber(detail::columnValue(counter, option));
+        }
+        if (files.has_value())
         {
+            out.append(separator);
+            out.appendNumber(files.value());
         }
-    };
+        out.append(separator); // no error
+        out.append('\n');
+    }
 
-    class BytesFormatHandler : public FormatHandler
+    auto OutputFormatter::writeError(OutputBuffer& out, std::string_view inputName, bool isStdin,
+                                     const ccwc::argument_parser::HealthStatus& health,
+                                     bool withFiles) const -> void
     {
-      protected:
-        auto handle(const ccwc::algorithm::Counter& counter) -> std::string override
+        using ccwc::output_format_options::ReportFormat;
+
+        std::string                     message = detail::errorMessage(inputName, health);
+        std::optional<std::string_view> name    = detail::recordName(inputName, isStdin);
+
+        if (m_report_format == ReportFormat::BINARY)
         {
-            return std::to_string(counter.bytes);
+            binary_report::Record record;
+            record.mType  = binary_report::RecordType::ERROR;
+            record.mErrno = static_cast<std::uint32_t>(health.mErrno);
+            record.mName  = name.value_or(std::string_view());
+            record.mError = message;
+            binary_report::appendRecord(out, record);
+            return;
         }
 
-      public:
-        explicit BytesFormatHandler(std::size_t max_length, bool enabled)
-            : FormatHandler(max_length, enabled)
+        if (m_report_format == ReportFormat::NDJSON)
         {
+            out.append(R"({"type":"error")");
+            if (name.has_value())
+            {
+                out.append(R"(,"name":)");
+                detail::appendJsonString(out, name.value());
+            }
+            out.append(R"(,"error":)");
+            detail::appendJsonString(out, message);
+            out.append("}\n");
+            return;
         }
-    };
-} // namespace ccwc::output_format_options
 
-namespace ccwc::output_formatter
-{
+        bool csv       = m_report_format == ReportFormat::CSV;
+        char separator = csv ? ',' : '\t';
 
-    auto OutputFormatter::addOption(ccwc::output_format_options::OutputFormatOptions option) -> void
+        out.append("error");
+        out.append(separator);
+        if (name.has_value())
+        {
+            csv ? detail::appendCsvField(out, name.value())
+                : detail::appendTsvField(out, name.value());
+        }
+        for (std::size_t i = 0; i < m_format_options.size() + (withFiles ? 1 : 0); ++i)
+        {
+            out.append(separator); // no counts
+        }
+        out.append(separator);
+        csv ? detail::appendCsvField(out, message) : detail::appendTsvField(out, message);
+        out.append('\n');
+    }
+
+    auto OutputFormatter::formatHeader(OutputBuffer& out) const -> void
     {
-        this->m_format_options.insert(option);
+        writeHeader(out, false);
+    }
+
+    auto OutputFormatter::formatTrailer(OutputBuffer& out) const -> void
+    {
+        if (!isStructured())
+        {
+            out.append('\n');
+        }
     }
 
-    auto OutputFormatter::buildFormatChain(std::size_t max_len_of_num) const
-        -> std::unique_ptr<ccwc::output_format_options::FormatHandler>
-    {
-        auto line = std::make_unique<ccwc::output_format_options::LinesFormatHandler>(
-            max_len_of_num,
-            IsOptionEnabled(ccwc::output_format_options::OutputFormatOptions::FORMAT_LINES));
-
-        // clang-format off
-        line
-            ->setNext(
-                std::make_unique<ccwc::output_format_options::WordsFormatHandler>(
-                    max_len_of_num,
-                    IsOptionEnabled(ccwc::output_format_options::OutputFormatOptions::FORMAT_WORDS)
-                )
-            )
-            ->setNext(
-                std::make_unique<ccwc::output_format_options::MultibyteFormatHandler>(
-                    max_len_of_num,
-                    IsOptionEnabled(ccwc::output_format_options::OutputFormatOptions::FORMAT_MULTIBYTE)
-                )
-            )
-            ->setNext(
-                std::make_unique<ccwc::output_format_options::BytesFormatHandler>(
-                    max_len_of_num,
-                    IsOptionEnabled(ccwc::output_format_options::OutputFormatOptions::FORMAT_BYTES)
-                )
-            );
-        // clang-format on
-
-        return line;
-    }
-
-    auto OutputFormatter::formatFile(
-        const std::vector<ccwc::algorithm::Counter>&               counters,
-        const std::vector<ccwc::argument_parser::InputDataObject>& inputDataObjects) const
-        -> std::string
+    auto OutputFormatter::formatFile(const ccwc::algorithm::ResultStore& results,
+                                     OutputBuffer&                       out) const -> void
     {
         ccwc::algorithm::Counter total_counter{};
 
-        for (const auto& counter : counters)
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            total_counter += results.counter(i);
+        }
+
+        if (m_total_mode == ccwc::output_format_options::TotalMode::ONLY)
+        {
+            formatTotalOnly(results, total_counter, out);
+            return;
+        }
+
+        std::size_t width = columnWidth(total_counter.bytes);
+
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            if (!formatRow(results.counter(i), results.name(i), results.isStdin(i),
+                           results.health(i), width, out))
+            {
+                return;
+            }
+        }
+
+        if (printsTotal(results.size()))
+        {
+            formatTotal(total_counter, width, out);
+        }
+    }
+
+    auto OutputFormatter::formatTotalOnly(const ccwc::algorithm::ResultStore& failures,
+                                          const ccwc::algorithm::Counter&     total,
+                                          OutputBuffer&                       out) const -> void
+    {
+        for (std::size_t i = 0; i < failures.size(); ++i)
+        {
+            const auto& health = failures.health(i);
+            if (!health.mIsHealthy)
+            {
+                // The total is all this report is for; a failure does not end it.
+                formatRow(failures.counter(i), failures.name(i), failures.isStdin(i), health, 0,
+                          out);
+            }
+        }
+        if (isStructured())
+        {
+            formatTotal(total, 0, out);
+            return;
+        }
+
+        // There are no rows to line up with: the bare numbers, as GNU wc prints them.
+        const char* separator = "";
+        for (auto option : m_format_options)
+        {
+            out.append(separator);
+            out.appendNumber(detail::columnValue(total, option));
+            separator = " ";
+        }
+        out.append('\n');
+    }
+
+    auto OutputFormatter::formatRow(const ccwc::algorithm::Counter&               counter,
+                                    const ccwc::argument_parser::InputDataObject& input,
+                                    std::size_t width, OutputBuffer& out) const -> bool
+    {
+        return formatRow(counter, input.mName, input.mIsStdin, input.mHealthStatus, width, out);
+    }
+
+    auto OutputFormatter::formatRow(const ccwc::algorithm::Counter& counter,
+                                    std::string_view name, bool isStdin,
+                                    const ccwc::argument_parser::HealthStatus& health,
+                                    std::size_t width, OutputBuffer& out) const -> bool
+    {
+        if (!health.mIsHealthy)
+        {
+            if (isStructured())
+            {
+                writeError(out, name, isStdin, health, false);
+                return true;
+            }
+            out.append(detail::errorMessage(name, health));
+            out.append('\n');
+            return false;
+        }
+
+        if (isStructured())
         {
-            total_counter += counter;
+            writeRecord(out, binary_report::RecordType::FILE, detail::recordName(name, isStdin),
+                        counter);
+            return true;
         }
 
-        std::size_t max_spaces{std::to_string(total_counter.bytes).length()};
+        writeColumns(out, counter, width);
+        if (!isStdin)
+        {
+            out.append(' ');
+            out.append(name);
+        }
+        out.append('\n');
+        return true;
+    }
 
-        auto format_chain = this->buildFormatChain(max_spaces);
+    auto OutputFormatter::formatTotal(const ccwc::algorithm::Counter& total, std::size_t width,
+                                      OutputBuffer& out) const -> void
+    {
+        if (isStructured())
+        {
+            writeRecord(out, binary_report::RecordType::TOTAL, std::nullopt, total);
+            return;
+        }
+        writeColumns(out, total, width);
+        out.append('\n');
+    }
 
-        std::string output;
-        bool        found_bad{false};
-        for (std::size_t i = 0; i < counters.size(); ++i)
+    auto OutputFormatter::formatRollup(const ccwc::algorithm::ResultStore& results,
+                                       std::size_t maxDepth, OutputBuffer& out) const -> void
+    {
+        // The tree is keyed by directory path; a std::map keeps parents before their children.
+        std::map<std::string, ccwc::algorithm::Counter, std::less<>> directories;
+        ccwc::algorithm::Counter                                     total_counter{};
+
+        writeHeader(out, false);
+        for (std::size_t i = 0; i < results.size(); ++i)
         {
+            const auto& health = results.health(i);
+            if (!health.mIsHealthy)
+            {
+                if (isStructured())
+                {
+                    writeError(out, results.name(i), results.isStdin(i), health, false);
+                    continue;
+                }
+                out.append(detail::errorMessage(results.name(i), health));
+                out.append('\n');
+                continue;
+            }
 
-            if (!inputDataObjects[i].mHealthStatus.mIsHealthy)
+            total_counter += results.counter(i);
+            if (results.isStdin(i))
             {
-                found_bad = true;
-                output += inputDataObjects[i].mHealthStatus.mErrorMessage + "\n";
-                break;
+                continue;
             }
+            auto addTo = [&](std::string_view directory) {
+                auto found = directories.find(directory);
+                if (found == directories.end())
+                {
+                    found = directories.emplace(std::string(directory), ccwc::algorithm::Counter{})
+                                .first;
+                }
+                found->second += results.counter(i);
+            };
+            detail::forEachDirectory(results.name(i), results.rootLength(i), maxDepth, addTo);
+        }
 
-            output = format_chain->doHandle(output, counters[i]);
+        std::size_t width = columnWidth(total_counter.bytes);
 
-            if (!inputDataObjects[i].mInputStream->isStdin())
+        for (const auto& [directory, counter] : directories)
+        {
+            if (isStructured())
             {
-                output += " " + inputDataObjects[i].mInputStream->name();
+                writeRecord(out, binary_report::RecordType::DIRECTORY, directory, counter);
+                continue;
             }
-            output += "\n";
+            writeColumns(out, counter, width);
+            out.append(' ');
+            out.append(directory);
+            out.append('\n');
         }
 
-        if (found_bad)
+        if (m_total_mode != ccwc::output_format_options::TotalMode::NEVER)
         {
-            return output;
+            formatTotal(total_counter, width, out);
         }
+    }
 
-        // else process total counter
-        if (inputDataObjects.size() > static_cast<std::size_t>(1))
+    auto OutputFormatter::formatGroups(const ccwc::algorithm::CounterGroups& groups,
+                                       const ccwc::algorithm::ResultStore&   ungrouped,
+                                       OutputBuffer&                         out) const -> void
+    {
+        writeHeader(out, true);
+        for (std::size_t i = 0; i < ungrouped.size(); ++i)
+        {
+            const auto& health = ungrouped.health(i);
+            if (!health.mIsHealthy)
+            {
+                // One vanished file among millions must not take the groups with it.
+                if (isStructured())
+                {
+                    writeError(out, ungrouped.name(i), ungrouped.isStdin(i), health, true);
+                    continue;
+                }
+                out.append(detail::errorMessage(ungrouped.name(i), health));
+                out.append('\n');
+            }
+        }
+
+        ccwc::algorithm::Counter total_counter{};
+        std::uint64_t            total_files{0};
+        for (const auto& [group, total] : groups.totals())
+        {
+            total_counter += total.mCounter;
+            total_files += total.mFiles;
+        }
+
+        std::size_t width = columnWidth(total_counter.bytes);
+
+        for (const auto& [group, total] : groups.totals())
+        {
+            if (isStructured())
+            {
+                writeRecord(out, binary_report::RecordType::GROUP, group, total.mCounter,
+                            total.mFiles);
+                continue;
+            }
+            writeColumns(out, total.mCounter, width);
+            out.append(' ');
+            out.append(group);
+            out.append(" (");
+            out.appendNumber(total.mFiles);
+            out.append(total.mFiles == 1 ? " file)\n" : " files)\n");
+        }
+
+        if (!printsTotal(groups.totals().size()))
+        {
+            return;
+        }
+        if (isStructured())
+        {
+            writeRecord(out, binary_report::RecordType::TOTAL, std::nullopt, total_counter,
+                        total_files);
+            return;
+        }
+        writeColumns(out, total_counter, width);
+        out.append('\n');
+    }
+
+    auto OutputFormatter::formatInterval(const ccwc::algorithm::Counter& delta,
+                                         const ccwc::algorithm::Counter& total,
+                                         OutputBuffer&                   out) const -> void
+    {
+        if (isStructured())
+        {
+            writeRecord(out, binary_report::RecordType::DELTA, std::nullopt, delta);
+            writeRecord(out, binary_report::RecordType::TOTAL, std::nullopt, total);
+            return;
+        }
+
+        std::size_t width = columnWidth(total.bytes);
+
+        writeColumns(out, delta, width);
+        out.append(" delta\n");
+        writeColumns(out, total, width);
+        out.append(" total\n");
+    }
+
+    auto OutputFormatter::formatPartial(const ccwc::algorithm::Counter& partial,
+                                        OutputBuffer&                   out) const -> void
+    {
+        if (isStructured())
         {
-            output = format_chain->doHandle(output, total_counter);
-            output += "\n";
+            writeRecord(out, binary_report::RecordType::INTERRUPTED, std::nullopt, partial);
+            return;
         }
-        return output;
+        writeColumns(out, partial, columnWidth(partial.bytes));
+        out.append(" total (interrupted)\n");
     }
 
     auto OutputFormatter::normalizeFormattingOptions() -> void
@@ -168,4 +804,4 @@ namespace ccwc::output_formatter
             m_format_options.insert(ccwc::output_format_options::OutputFormatOptions::FORMAT_BYTES);
         }
     }
-} // namespace ccwc::output_formatter
\ No newline at end of file
+} // namespace ccwc::output_formatter
@@ -2,12 +2,18 @@
 #define CCWC_OUTPUT_FORMATTER_HPP
 
 #include "algorithm/counter.hpp"
+#include "algorithm/counter_groups.hpp"
+#include "algorithm/result_store.hpp"
 #include "argument_parser/input_objects.hpp"
+#include "binary_report.hpp"
+#include "output_buffer.hpp"
 
+#include <cstddef>
 #include <cstdint>
-#include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace ccwc::output_format_options
@@ -28,135 +34,121 @@ namespace ccwc::output_format_options
     };
 
     /**
-     * @brief Abstract class that will be used to handle the different options for the output
-     * formatter.
+     * @brief Layout of the whole report, selected with `--format`.
      */
-    class FormatHandler
+    enum class ReportFormat : std::uint8_t
     {
-      private:
-        /**
-         * @brief The next handler in the chain.
-         */
-        std::unique_ptr<FormatHandler> m_next{nullptr};
+        TEXT,   // Padded columns, like wc.
+        NDJSON, // One JSON object per line.
+        CSV,    // RFC 4180, with a header row.
+        TSV,    // Tab separated, with a header row; tabs and newlines in names are escaped.
+        BINARY, // Length-prefixed fixed-layout records, see binary_report.hpp.
+    };
+
+    /**
+     * @brief When the total row is printed, selected with `--total` (as in GNU wc).
+     */
+    enum class TotalMode : std::uint8_t
+    {
+        AUTO,   // With more than one input (text), always (structured formats).
+        ALWAYS, // Even for a single input.
+        ONLY,   // Only the total: per-file rows are neither printed nor kept.
+        NEVER,  // Never.
+    };
+
+    /**
+     * @brief Parse a mode as accepted by `--total=WHEN`.
+     * @return The mode, or std::nullopt if the name is unknown.
+     */
+    auto parseTotalMode(std::string_view name) -> std::optional<TotalMode>;
+
+    /**
+     * @brief Parse a format name as accepted by `--format=FORMAT`.
+     * @return The format, or std::nullopt if the name is unknown.
+     */
+    auto parseReportFormat(std::string_view name) -> std::optional<ReportFormat>;
 
+} // namespace ccwc::output_format_options
+
+namespace ccwc::output_formatter
+{
+
+    /**
+     * @brief OutputFormatter class that will be used to format the output of the program.
+     */
+    class OutputFormatter
+    {
+
+      private:
         /**
-         * @brief The maximum length of the number.
+         * @brief The format options to use.
          */
-        std::size_t m_max_len_of_num;
+        std::set<ccwc::output_format_options::OutputFormatOptions> m_format_options;
 
         /**
-         * @brief Whether the handler is enabled.
+         * @brief Fixed width of the numbers, if `--width` was given.
          */
-        bool m_enabled{true};
+        std::optional<std::size_t> m_width;
 
-      protected:
         /**
-         * @brief Handle the counter and return the output.
-         *
-         * @param counter The counter to handle.
-         * @return The output string.
+         * @brief The layout of the report.
          */
-        virtual auto handle(const ccwc::algorithm::Counter& counter) -> std::string = 0;
+        ccwc::output_format_options::ReportFormat m_report_format{
+            ccwc::output_format_options::ReportFormat::TEXT};
 
-      public:
         /**
-         * @brief Constructor for the FormatHandler class.
+         * @brief When the total row is printed.
          */
-        FormatHandler(std::size_t max_len_of_num)
-            : m_next(nullptr), m_max_len_of_num(max_len_of_num), m_enabled(true)
-        {
-        }
-
-        FormatHandler(std::size_t max_len_of_num, bool enabled)
-            : m_next(nullptr), m_max_len_of_num(max_len_of_num), m_enabled(enabled)
-        {
-        }
+        ccwc::output_format_options::TotalMode m_total_mode{
+            ccwc::output_format_options::TotalMode::AUTO};
 
         /**
-         * @brief Disable copy operations (not suitable for chain of responsibility)
+         * @brief Width of the numbers of a report whose largest number is `largest`.
          */
-        FormatHandler(const FormatHandler&)                    = delete;
-        auto operator=(const FormatHandler&) -> FormatHandler& = delete;
+        [[nodiscard]] auto columnWidth(std::uint64_t largest) const -> std::size_t;
 
         /**
-         * @brief Enable move operations (useful for transferring ownership)
+         * @brief Write the enabled columns of a counter, each right-aligned in `width + 2`
+         * characters.
          */
-        FormatHandler(FormatHandler&&)                    = default;
-        auto operator=(FormatHandler&&) -> FormatHandler& = default;
+        auto writeColumns(OutputBuffer& out, const ccwc::algorithm::Counter& counter,
+                          std::size_t width) const -> void;
 
         /**
-         * @brief Set the next handler in the chain.
-         *
-         * You should use this as a chain for example:
+         * @brief Write one record of a structured report: a file, directory, group or total.
          *
-         * ```
-         * auto handler = std::make_unique<LinesHandler>();
-         * handler->setNext(std::make_unique<WordsHandler>())
-         *        ->setNext(std::make_unique<MultibyteHandler>())
-         *        ->setNext(std::make_unique<BytesHandler>());
-         * ```
-         *
-         * @param handler The next handler in the chain.
-         * @return Raw pointer to the next handler for chaining.
+         * @param type The kind of record.
+         * @param name The file, directory or group, none for totals and the standard input.
+         * @param files Number of files of a group; only group reports have this field.
          */
-        auto setNext(std::unique_ptr<FormatHandler> handler) -> FormatHandler*
-        {
-            FormatHandler* result = handler.get();
-            m_next                = std::move(handler);
-            return result;
-        }
+        auto writeRecord(OutputBuffer& out, binary_report::RecordType type,
+                         std::optional<std::string_view> name,
+                         const ccwc::algorithm::Counter& counter,
+                         std::optional<std::uint64_t>    files = std::nullopt) const -> void;
 
         /**
-         * @brief Handle the counter and return the output.
+         * @brief Write the error record of an input that could not be counted.
          *
-         * @param output The output string.
-         * @param counter The counter to handle.
-         * @return The updated output string.
+         * @param withFiles Whether the report has a `files` column.
          */
-        auto doHandle(std::string& output, const ccwc::algorithm::Counter& counter) -> std::string
-        {
-            if (m_enabled)
-            {
-                std::string handle_string = this->handle(counter);
-                std::size_t total_spaces_to_add =
-                    1 + (m_max_len_of_num + 1) - handle_string.length();
-                std::string normalized_handle_string =
-                    std::string(total_spaces_to_add, ' ') + handle_string;
-
-                output += normalized_handle_string;
-            }
-            if (m_next != nullptr)
-            {
-                return m_next->doHandle(output, counter);
-            }
-            return output;
-        }
+        auto writeError(OutputBuffer& out, std::string_view inputName, bool isStdin,
+                        const ccwc::argument_parser::HealthStatus& health, bool withFiles) const
+            -> void;
 
         /**
-         * @brief Destructor - automatically handles cleanup via unique_ptr
+         * @brief Format the row of one input: its columns and name, or its error.
          */
-        virtual ~FormatHandler() = default;
-    };
+        auto formatRow(const ccwc::algorithm::Counter& counter, std::string_view name,
+                       bool isStdin, const ccwc::argument_parser::HealthStatus& health,
+                       std::size_t width, OutputBuffer& out) const -> bool;
 
-} // namespace ccwc::output_format_options
-
-namespace ccwc::output_formatter
-{
-
-    /**
-     * @brief OutputFormatter class that will be used to format the output of the program.
-     */
-    class OutputFormatter
-    {
-
-      private:
         /**
-         * @brief The format options to use.
+         * @brief Write the header row of a CSV or TSV report, or the header of a binary one;
+         * nothing for the other formats.
+         *
+         * @param withFiles Whether the report has a `files` column.
          */
-        std::set<ccwc::output_format_options::OutputFormatOptions> m_format_options;
-
-        auto buildFormatChain(std::size_t max_len_of_num) const
-            -> std::unique_ptr<ccwc::output_format_options::FormatHandler>;
+        auto writeHeader(OutputBuffer& out, bool withFiles) const -> void;
 
         auto IsOptionEnabled(ccwc::output_format_options::OutputFormatOptions option) const -> bool
         {
@@ -179,14 +171,135 @@ namespace ccwc::output_formatter
         auto addOption(ccwc::output_format_options::OutputFormatOptions option) -> void;
 
         /**
-         * @brief Format the file.
+         * @brief Use a fixed width for the numbers instead of the width of the largest one.
+         */
+        auto setWidth(std::size_t width) -> void;
+
+        /**
+         * @brief The fixed width of the numbers, if one was set.
+         */
+        [[nodiscard]] auto width() const -> const std::optional<std::size_t>&;
+
+        /**
+         * @brief Select the layout of the report.
+         */
+        auto setReportFormat(ccwc::output_format_options::ReportFormat format) -> void;
+
+        /**
+         * @brief Whether the report is made of records (NDJSON, CSV, TSV or binary) rather than
+         * padded text.
+         */
+        [[nodiscard]] auto isStructured() const -> bool;
+
+        /**
+         * @brief Select when the total row is printed.
+         */
+        auto setTotalMode(ccwc::output_format_options::TotalMode mode) -> void;
+
+        /**
+         * @brief When the total row is printed.
+         */
+        [[nodiscard]] auto totalMode() const -> ccwc::output_format_options::TotalMode;
+
+        /**
+         * @brief Whether a report of `rows` rows ends with a total.
+         *
+         * By default text reports only have one for several rows; structured ones always do, so
+         * their readers can rely on it.
+         */
+        [[nodiscard]] auto printsTotal(std::size_t rows) const -> bool;
+
+        /**
+         * @brief Format what comes before the rows of a per-file report: the CSV or TSV header
+         * row, or the binary header.
+         */
+        auto formatHeader(OutputBuffer& out) const -> void;
+
+        /**
+         * @brief Format what comes after a report: the empty line of the text layout.
+         */
+        auto formatTrailer(OutputBuffer& out) const -> void;
+
+        /**
+         * @brief Format the row of one input: its columns and name, or its error.
+         *
+         * @param width Width of the numbers.
+         * @return Whether the report goes on: the text layout stops at the first error, the
+         * structured ones record it and carry on.
+         */
+        auto formatRow(const ccwc::algorithm::Counter&               counter,
+                       const ccwc::argument_parser::InputDataObject& input, std::size_t width,
+                       OutputBuffer& out) const -> bool;
+
+        /**
+         * @brief Format the total row.
+         *
+         * @param width Width of the numbers.
+         */
+        auto formatTotal(const ccwc::algorithm::Counter& total, std::size_t width,
+                         OutputBuffer& out) const -> void;
+
+        /**
+         * @brief Format one row per input followed by the total.
+         *
+         * The rows are written straight into `out`; nothing is built up in memory. The header
+         * is left to formatHeader(), so rolling reports can share theirs with the final one.
+         */
+        auto formatFile(const ccwc::algorithm::ResultStore& results, OutputBuffer& out) const
+            -> void;
+
+        /**
+         * @brief Format the report of `--total=only`: the inputs that failed, then the total,
+         * which is printed whatever failed. As in GNU wc, the text total is the bare numbers
+         * separated by single spaces, with no column padding.
+         *
+         * @param failures The inputs that failed; the others may or may not be there, they are
+         * not printed.
+         * @param total The total of every input.
+         */
+        auto formatTotalOnly(const ccwc::algorithm::ResultStore& failures,
+                             const ccwc::algorithm::Counter& total, OutputBuffer& out) const
+            -> void;
+
+        /**
+         * @brief Format one row per directory with the totals of every file below it (du-style).
+         *
+         * @param maxDepth Directories deeper than this many path components are not printed
+         * (their files still count towards their shallower ancestors).
+         */
+        auto formatRollup(const ccwc::algorithm::ResultStore& results, std::size_t maxDepth,
+                          OutputBuffer& out) const -> void;
+
+        /**
+         * @brief Format one row per group followed by the total.
+         *
+         * @param groups The per-group totals.
+         * @param ungrouped The inputs that were not grouped (the failures).
+         * @param out Where the rows are written.
+         */
+        auto formatGroups(const ccwc::algorithm::CounterGroups& groups,
+                          const ccwc::algorithm::ResultStore&   ungrouped,
+                          OutputBuffer&                         out) const -> void;
+
+        /**
+         * @brief Format a rolling report: the counts since the previous report, then the totals.
+         *
+         * @param delta What was counted since the previous report.
+         * @param total What was counted so far.
+         * @param out Where the rows are written.
+         */
+        auto formatInterval(const ccwc::algorithm::Counter& delta,
+                            const ccwc::algorithm::Counter& total, OutputBuffer& out) const
+            -> void;
+
+        /**
+         * @brief Format the totals of an interrupted count.
          *
-         * @return The formatted output.
+         * @param partial What was counted before the interruption.
+         * @param out Where the row is written.
          */
-        [[nodiscard]] auto formatFile(
-            const std::vector<ccwc::algorithm::Counter>&               counters,
-            const std::vector<ccwc::argument_parser::InputDataObject>& inputDataObjects) const
-            -> std::string;
+        auto formatPartial(const ccwc::algorithm::Counter& partial, OutputBuffer& out) const
+            -> void;
 
         /**
          * @brief Normalize the formatting options.
@@ -0,0 +1,104 @@
+#include "streaming_report.hpp"
+
+#include "algorithm/trace.hpp"
+
+#include <chrono>
+
+namespace ccwc::output_formatter
+{
+    namespace detail
+    {
+        constexpr std::chrono::milliseconds STREAMING_FLUSH_INTERVAL{100};
+    } // namespace detail
+
+    StreamingReport::StreamingReport(const OutputFormatter& formatter, std::size_t width)
+        : m_formatter(formatter), m_width(width),
+          m_total_only(formatter.totalMode() == ccwc::output_format_options::TotalMode::ONLY),
+          m_flusher([this] { flushPeriodically(); })
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_formatter.formatHeader(m_out);
+    }
+
+    StreamingReport::~StreamingReport()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_wake.notify_one();
+        m_flusher.join();
+    }
+
+    auto StreamingReport::flushPeriodically() -> void
+    {
+        ccwc::algorithm::nameTracedThread("report flusher");
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_done)
+        {
+            m_wake.wait_for(lock, detail::STREAMING_FLUSH_INTERVAL);
+            ccwc::algorithm::TraceSpan span("flush");
+            m_out.flush();
+        }
+    }
+
+    auto StreamingReport::print(const ccwc::argument_parser::InputDataObject& input,
+                                const ccwc::algorithm::Counter&               counter) -> void
+    {
+        if (m_total_only)
+        {
+            if (input.mHealthStatus.mIsHealthy)
+            {
+                m_total += counter;
+            }
+            else
+            {
+                m_formatter.formatRow(counter, input, m_width, m_out);
+            }
+        }
+        else if (!m_failed)
+        {
+            m_failed = !m_formatter.formatRow(counter, input, m_width, m_out);
+            m_total += counter;
+        }
+        ++m_next;
+    }
+
+    auto StreamingReport::add(std::size_t                                   index,
+                              const ccwc::argument_parser::InputDataObject& input,
+                              const ccwc::algorithm::Counter&               counter) -> void
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (index != m_next)
+        {
+            m_waiting.try_emplace(index, input, counter);
+            return;
+        }
+
+        print(input, counter);
+        for (auto waiting = m_waiting.begin();
+             waiting != m_waiting.end() && waiting->first == m_next;
+             waiting = m_waiting.erase(waiting))
+        {
+            print(waiting->second.first, waiting->second.second);
+        }
+    }
+
+    auto StreamingReport::finish() -> void
+    {
+        std::lock_guard<std::mutex>  lock(m_mutex);
+        ccwc::algorithm::TraceSpan span("format");
+        if (m_total_only)
+        {
+            // The failures were printed already.
+            m_formatter.formatTotalOnly(ccwc::algorithm::ResultStore{}, m_total, m_out);
+        }
+        else if (!m_failed && m_formatter.printsTotal(m_next))
+        {
+            m_formatter.formatTotal(m_total, m_width, m_out);
+        }
+        m_formatter.formatTrailer(m_out);
+        m_out.flush();
+    }
+
+} // namespace ccwc::output_formatter
@@ -0,0 +1,94 @@
+#ifndef CCWC_STREAMING_REPORT_HPP
+#define CCWC_STREAMING_REPORT_HPP
+
+#include "algorithm/counter.hpp"
+#include "argument_parser/input_objects.hpp"
+#include "output_buffer.hpp"
+#include "output_formatter.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace ccwc::output_formatter
+{
+
+    /**
+     * @brief Prints the row of each input as soon as it is counted, in input order.
+     *
+     * The column width has to be known before the first row, so it comes from `--width` or
+     * from an upper bound such as the summed sizes of the input files. Counters that arrive
+     * before the ones of earlier inputs wait in a reorder buffer. Rows go through an
+     * OutputBuffer that is written out when full and by a background thread every 100ms, so a
+     * large batch shows up as it goes without a write per row. Like formatFile(), the report
+     * stops at the first input that failed.
+     *
+     * With `--total=only` it prints the inputs that failed as they are counted and sums up the
+     * others, then the total at the width it needs; nothing is kept per input.
+     */
+    class StreamingReport
+    {
+      private:
+        using CountedInput =
+            std::pair<ccwc::argument_parser::InputDataObject, ccwc::algorithm::Counter>;
+
+        const OutputFormatter&              m_formatter;
+        std::size_t                         m_width;
+        OutputBuffer                        m_out;
+        std::map<std::size_t, CountedInput> m_waiting;
+        std::size_t                         m_next{0};
+        ccwc::algorithm::Counter            m_total;
+        bool                                m_failed{false};
+        bool                                m_total_only{false};
+        std::mutex                          m_mutex; // guards m_out
+        std::condition_variable             m_wake;
+        bool                                m_done{false};
+        std::thread                         m_flusher;
+
+        /**
+         * @brief Print the row of the next input.
+         */
+        auto print(const ccwc::argument_parser::InputDataObject& input,
+                   const ccwc::algorithm::Counter&               counter) -> void;
+
+        /**
+         * @brief Body of the flusher thread.
+         */
+        auto flushPeriodically() -> void;
+
+      public:
+        /**
+         * @brief Constructor.
+         * @param formatter Formats the rows.
+         * @param width Width of the numbers; unused with `--total=only`.
+         */
+        StreamingReport(const OutputFormatter& formatter, std::size_t width);
+
+        /**
+         * @brief Destructor: stops the flusher thread.
+         */
+        ~StreamingReport();
+
+        StreamingReport(const StreamingReport&)                    = delete;
+        auto operator=(const StreamingReport&) -> StreamingReport& = delete;
+        StreamingReport(StreamingReport&&)                         = delete;
+        auto operator=(StreamingReport&&) -> StreamingReport&      = delete;
+
+        /**
+         * @brief The input at `index` was counted; its health is final.
+         */
+        auto add(std::size_t index, const ccwc::argument_parser::InputDataObject& input,
+                 const ccwc::algorithm::Counter& counter) -> void;
+
+        /**
+         * @brief Print the total row, once every counter was added.
+         */
+        auto finish() -> void;
+    };
+
+} // namespace ccwc::output_formatter
+
+#endif // CCWC_STREAMING_REPORT_HPP